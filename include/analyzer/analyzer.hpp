@@ -2,22 +2,37 @@
 #define ANALYZER_HPP
 
 #include "symbol_table.hpp"
+#include "thread_pool.hpp"
+#include "traversal.hpp"
 #include "visitor.hpp"
 
-class Analyzer : public Visitor {
+#include <deque>
+#include <exception>
+#include <optional>
+#include <unordered_map>
+
+// Visit methods run once the children of a node have been analyzed
+class Analyzer : public Visitor, public Traversal {
 public:
-    Analyzer(const std::string& path);
+    // With more than one job, large sibling blocks are analyzed on a thread pool
+    Analyzer(const std::string& path, size_t jobs = 1);
     
 public:
     SymbolTable& analyze(ASTNode& root);
     static void symbDebug(const std::string& name, Symbol* symbol);
 
 private:
+    bool preVisit(ASTNode& node) override;
+    ASTNode* nextChild(ASTNode& node, size_t& step) override;
+    void postVisit(ASTNode& node) override;
+    void checkDeclaredName(const std::string& name, ASTNode* node);
+
     void visit(IdentifierNode&) override;
     void visit(ConstantNode&) override;
     void visit(BinaryOpNode&) override;
     void visit(ArrayIndexNode&) override;
     void visit(AssignmentNode&) override;
+    void visit(UpdateNode&) override;
     void visit(EmptyStatementNode&) override;
     void visit(CompoundStatementNode&) override;
     void visit(ForNode&) override;
@@ -27,7 +42,26 @@ private:
     void visit(MainDeclNode&) override;
     void visit(ProgramNode&) override;
 
+    struct Diagnostic {
+        size_t line, column;
+        std::string message;
+    };
+
+    // Sibling block analyzed by a worker against a snapshot of the enclosing scopes
+    struct SiblingTask {
+        StatementNode *block = nullptr;
+        std::optional<Diagnostic> diagnostic;
+        std::exception_ptr exception; // Any other failure of the worker
+        SymbolTable symbolTable; // Owns the symbols declared by the worker
+    };
+
+    Analyzer(const std::string& path, std::shared_ptr<const ScopeSnapshot> outerScope);
+    bool isParallelCandidate(StatementNode* statement) const;
+    void dispatch(StatementNode& block);
+    void reportDiagnostics(std::optional<Diagnostic> failure);
+
     int32_t evaluateConstantExpression(ExpressionNode*);
+    InitializerImage buildInitializerImage(ArrayDeclNode& node, size_t size) const;
     bool isIntegerType(ASTNode::DataType type) const;
     
     void error(const std::string& error, ASTNode* node) const;
@@ -36,6 +70,13 @@ private:
 private:
     SymbolTable m_symbolTable;
     std::string m_filePath;
+
+    static constexpr size_t PARALLEL_MIN_STATEMENTS = 64;
+
+    std::unique_ptr<ThreadPool> m_pool;
+    std::deque<SiblingTask> m_tasks;   // Deque keeps the task addresses stable for the workers
+    std::unordered_map<const StatementNode*, size_t> m_statementCounts; // Of the blocks and loops, counted once
+    bool m_isCollectingDiagnostics = false; // Errors are thrown instead of terminating the process
 };
 
 #endif // ANALYZER_HPP
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef ARITHMETIC_HPP
+#define ARITHMETIC_HPP
+
+#include "ast.hpp"
+
+#include <cstdint>
+
+// Value of the given integer type holding the low-order bits of `value`
+int64_t narrowToType(ASTNode::DataType type, int64_t value);
+// The same value held in the alternative of the type; empty for a type which isn't an integer
+ValueVariant typedValue(ASTNode::DataType type, int64_t value);
+
+// Size in bytes of a value of the given integer type in packed storage
+size_t typeSize(ASTNode::DataType type);
+// Stores the low-order bytes of `value` at `bytes`, and loads them back sign-extended
+void packValue(ASTNode::DataType type, int64_t value, unsigned char* bytes);
+int64_t unpackValue(ASTNode::DataType type, const unsigned char* bytes);
+
+// Computes `lhs op rhs` exactly as the Interpreter does: in 64 bits with
+// wrap-around, narrowed to `resultType`. Returns false when the operation
+// traps at runtime (division by zero, shift amount out of range).
+bool evaluateOperator(ASTNode::OperatorType op, int64_t lhs, int64_t rhs, ASTNode::DataType resultType, int64_t& result);
+
+// Multiply-high (or shift) sequence dividing by `divisor`; false for 0, 1, -1 and INT64_MIN
+bool planDivision(int64_t divisor, DivisionPlan& plan);
+// Truncating quotient and remainder computed with a plan, equal to `/` and `%`
+int64_t divideByPlan(const DivisionPlan& plan, int64_t dividend);
+int64_t remainderByPlan(const DivisionPlan& plan, int64_t dividend);
+
+// Value of an integer or character constant, narrowed to its resolved type
+bool constantValue(const ExpressionNode* node, int64_t& value);
+
+#endif // ARITHMETIC_HPP
@@ -5,16 +5,22 @@
 #include <memory>
 #include <vector>
 #include <variant>
+#include <optional>
+#include <cstdint>
 
 #include "visitor.hpp"
 
 struct Symbol; // Forward declaration
 
+using ValueVariant = std::variant<std::monostate, char, int, long, short>;
+
 struct ASTNode {
     ASTNode(size_t line, size_t column);
     virtual ~ASTNode() = default;
     virtual void accept(Visitor& visitor) = 0;
     virtual std::string toString() const = 0;
+    // Child nodes in evaluation order; nullptr past the last one
+    virtual ASTNode* child(size_t index);
 
     // Types of data
     enum class DataType {
@@ -76,6 +82,7 @@ struct IdentifierNode : ExpressionNode {
 
     std::string name;
     Symbol *symbolPtr = nullptr;
+    bool isInitialized = false; // Proven by the optimizer, a read never finds the variable uninitialized
 };
 
 // Node for constants
@@ -89,15 +96,37 @@ struct ConstantNode : ExpressionNode {
     ConstantType type;
 };
 
+// Division or modulo by a constant, lowered by the optimizer
+struct DivisionPlan {
+    int64_t divisor;
+    int64_t magic;     // Multiplier of the multiply-high sequence
+    int shift;
+    bool isPowerOfTwo; // Shift with a rounding bias instead of multiplying
+};
+
+// Initializer of an array computed by the Analyzer: the elements of the list
+// (or the characters of the string) as values of the array's type, copied in
+// bulk, then the elements which aren't constant, evaluated and patched over it
+struct InitializerImage {
+    std::vector<ValueVariant> values; // Zero where an element is patched
+    std::vector<size_t> patches;      // Indices of the elements evaluated at runtime
+    size_t zeroTail;                  // Elements after the initializer, set to `zero`
+    ValueVariant zero;
+    std::vector<unsigned char> packed; // The values in the storage type of a narrowed array
+};
+
 // Node for binary statements
 struct BinaryOpNode : ExpressionNode {
     BinaryOpNode(size_t line, size_t column);
 
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
     
     OperatorType op;
     std::unique_ptr<ExpressionNode> left, right;
+    // When set, the right operand is the constant divisor and isn't evaluated
+    std::optional<DivisionPlan> divisionPlan;
 };
 
 // Node for an array indexing
@@ -106,9 +135,12 @@ struct ArrayIndexNode : ExpressionNode {
     
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     std::unique_ptr<IdentifierNode> identifier;
     std::unique_ptr<ExpressionNode> indexExpression;
+    bool isIndexInBounds = false; // Proven by the optimizer, the bounds check is skipped
+    bool isInitialized = false;   // Proven by the optimizer, a read never finds the element uninitialized
 };
 
 // Node for assignment statements
@@ -117,17 +149,32 @@ struct AssignmentNode : StatementNode {
 
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     std::unique_ptr<ExpressionNode> left;
     std::unique_ptr<ExpressionNode> right;
 };
 
+// Assignment `target = target op value` made by the optimizer, which reads the
+// target and stores to it through a single evaluation of its index. The passes
+// still see the assignment it was: `right` is the operation, and its left
+// operand is the read of the target.
+struct UpdateNode : AssignmentNode {
+    UpdateNode(size_t line, size_t column);
+
+    void accept(Visitor& visitor) override;
+    std::string toString() const override;
+};
+
 // Node for empty statements
 struct EmptyStatementNode : StatementNode {
     EmptyStatementNode(size_t line, size_t column);
 
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+
+    // Trace line the Interpreter prints in place of a statement the optimizer removed
+    std::string trace;
 };
 
 // Node for compound statements
@@ -136,6 +183,7 @@ struct CompoundStatementNode : StatementNode {
     
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     std::vector<std::unique_ptr<StatementNode>> statements;
 };
@@ -146,6 +194,7 @@ struct ForNode : StatementNode {
     
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     std::unique_ptr<AssignmentNode> init = nullptr;
     std::unique_ptr<ExpressionNode> condition = nullptr;
@@ -159,6 +208,7 @@ struct VariableDeclNode : DeclarationNode {
     
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     // Either a base type, either a typedef-name 
     DataType type = DataType::UNKNOWN;
@@ -174,6 +224,7 @@ struct ArrayDeclNode : DeclarationNode {
     
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     // Either a base type, either a typedef-name 
     DataType baseType;
@@ -184,6 +235,7 @@ struct ArrayDeclNode : DeclarationNode {
 
     std::vector<std::unique_ptr<ExpressionNode>> braceListInit;
     std::unique_ptr<ConstantNode> stringLiteralInit;
+    std::optional<InitializerImage> initializerImage;
 };
 
 // Node for typedef-statements
@@ -206,6 +258,7 @@ struct MainDeclNode : DeclarationNode {
     
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     std::unique_ptr<IdentifierNode> name;
     std::unique_ptr<CompoundStatementNode> body;
@@ -217,6 +270,7 @@ struct ProgramNode : ASTNode {
     
     void accept(Visitor& visitor) override;
     std::string toString() const override;
+    ASTNode* child(size_t index) override;
 
     std::vector<std::unique_ptr<DeclarationNode>> declarations;
 };
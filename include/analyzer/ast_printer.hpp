@@ -2,18 +2,24 @@
 #define AST_PRINTER_HPP
 
 #include "visitor.hpp"
+#include "traversal.hpp"
 #include "ast.hpp"
 
-class ASTPrinter : public Visitor {
+// Visit methods print a node on entry and tell whether its children are printed too
+class ASTPrinter : public Visitor, public Traversal {
 public:
     void print(ASTNode& root);
 
 private:
+    bool preVisit(ASTNode& node) override;
+    void postVisit(ASTNode& node) override;
+
     void visit(IdentifierNode&) override;
     void visit(ConstantNode&) override;
     void visit(BinaryOpNode&) override;
     void visit(ArrayIndexNode&) override;
     void visit(AssignmentNode&) override;
+    void visit(UpdateNode&) override;
     void visit(EmptyStatementNode&) override;
     void visit(CompoundStatementNode&) override;
     void visit(ForNode&) override;
@@ -29,6 +35,7 @@ private:
 
 private:
     size_t m_indentationLevel = 0;
+    bool m_isDescending = false;
 };
 
 #endif // AST_PRINTER_HPP
\ No newline at end of file
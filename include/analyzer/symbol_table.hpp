@@ -2,28 +2,88 @@
 #define SYMBOL_TABLE_HPP
 
 #include <vector>
-#include <unordered_map>
+#include <memory>
 #include <variant>
+#include <cstdint>
+#include <unordered_map>
 
 #include "ast.hpp"
 
-using ValueVariant = std::variant<std::monostate, char, int, long, short>;
+struct Symbol;
+
+// Optimizer data which only a few symbols get, kept out of the records the
+// analysis and the Interpreter walk
+struct SymbolDetails {
+    // Scalar replacement: a promoted element knows its array and index, the array its promoted elements
+    Symbol *elementOf = nullptr;
+    int64_t elementIndex = -1;
+    std::vector<Symbol*> promotedElements;
+    // An array narrowed by the optimizer packs its elements in `storageType` and marks the initialized ones
+    ASTNode::DataType storageType = ASTNode::DataType::UNKNOWN;
+    std::vector<unsigned char> packedValues;
+    std::vector<bool> initializedValues;
+
+    static const SymbolDetails NONE; // Details of the symbols which have none
+};
 
 struct Symbol {
+    // Fields read by the semantic analysis, kept together at the front
     ASTNode::DataType type;
-    bool isArray = false;
     int32_t arraySize = -1;
+    bool isArray = false;
     bool isTypedef = false;
+
+    // Fields used by the Interpreter on every access
+    bool isCompilerTemporary = false; // Introduced by an optimization, not traced
     DeclarationNode *declarationNode;
     ValueVariant value;
     std::vector<ValueVariant> arrayValues;
+    // Symbol whose storage this one shares, when their lifetimes don't overlap
+    Symbol *slotOwner = nullptr;
+
+    // Storage the Interpreter reads and writes for this symbol
+    Symbol& slot() { return slotOwner ? *slotOwner : *this; }
+    const Symbol& slot() const { return slotOwner ? *slotOwner : *this; }
+
+    const SymbolDetails& details() const { return m_details ? *m_details : SymbolDetails::NONE; }
+    // Details to write to, allocated on the first write
+    SymbolDetails& editDetails();
+
+private:
+    std::unique_ptr<SymbolDetails> m_details;
+};
+
+// Append-only storage for every symbol of a compilation. Symbols are never
+// moved or destroyed individually, so the pointers kept in the AST stay valid
+// after their scope is left; all of them are freed at once, chunk by chunk.
+class SymbolArena {
+public:
+    uint32_t allocate(Symbol&& symbol);
+    Symbol& operator[](uint32_t index);
+    const Symbol& operator[](uint32_t index) const;
+    // Take over the chunks of another arena; its symbols keep their addresses
+    void adopt(SymbolArena&& other);
+
+private:
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    std::vector<std::unique_ptr<Symbol[]>> m_chunks;
+    std::vector<std::unique_ptr<Symbol[]>> m_adoptedChunks;
+    size_t m_size = 0;
 };
 
-using Scope = std::unordered_map<std::string, Symbol>;
+// Immutable view of every name visible at some point of the analysis
+using ScopeSnapshot = std::unordered_map<std::string, Symbol*>;
 
+// Single open-addressing table of interned names. Every name keeps a chain of
+// its bindings from the innermost scope outwards, and the bindings themselves
+// form an undo log which is unwound when a scope is left. Bindings only index
+// the arena, so leaving a scope never destroys a symbol.
 class SymbolTable {
 public:
     SymbolTable();
+    // Table whose lookups fall back to a frozen view of the enclosing scopes
+    explicit SymbolTable(std::shared_ptr<const ScopeSnapshot> outerScope);
     ~SymbolTable();
 
     bool isUniqueInCurrentScope(const std::string& name) const;
@@ -33,9 +93,48 @@ public:
     void enterScope();
     void leaveScope();
 
+    std::shared_ptr<const ScopeSnapshot> snapshot();
+    void adopt(SymbolTable&& other);
+
+    // Symbol which is never bound to a name, for values introduced by the optimizer
+    Symbol* createAnonymous(Symbol&& symbol);
+    // The same, for a compiler temporary which the Interpreter doesn't trace
+    Symbol* createTemporary(Symbol&& symbol);
+    size_t temporaryCount() const;
+
 private:
-    std::vector<Scope> m_scopeStack;
-    bool isMainDeclared;
+    static constexpr uint32_t NO_NAME = UINT32_MAX;
+    static constexpr int32_t NO_BINDING = -1;
+    static constexpr size_t INITIAL_BUCKETS = 64; // Must be a power of two
+
+    struct Name {
+        std::string spelling;
+        size_t hash;
+        int32_t innermost = NO_BINDING; // Index of the visible binding in m_bindings
+    };
+
+    struct Binding {
+        uint32_t nameId;
+        uint32_t depth;    // Index of the scope which owns the binding
+        int32_t shadowed;  // Binding of the same name in an enclosing scope
+        uint32_t symbolId; // Index of the symbol in the arena
+    };
+
+    uint32_t findName(const std::string& name) const;
+    uint32_t internName(const std::string& name);
+    void rehash(size_t bucketCount);
+    uint32_t currentDepth() const;
+
+private:
+    std::vector<Name> m_names;         // Interned names, indexed by name id
+    std::vector<uint32_t> m_buckets;   // Name id + 1 for every occupied bucket, 0 for an empty one
+    std::vector<Binding> m_bindings;   // Undo log of the visible bindings
+    std::vector<size_t> m_scopeMarks;  // Size of m_bindings at the moment each scope was entered
+    SymbolArena m_arena;
+    size_t m_temporaryCount = 0;
+
+    std::shared_ptr<const ScopeSnapshot> m_outerScope;
+    std::shared_ptr<const ScopeSnapshot> m_snapshot; // Reset whenever the visible names change
 };
 
-#endif // SYMBOL_TABLE_HPP
\ No newline at end of file
+#endif // SYMBOL_TABLE_HPP
@@ -0,0 +1,38 @@
+#ifndef TRAVERSAL_HPP
+#define TRAVERSAL_HPP
+
+#include "ast.hpp"
+
+#include <vector>
+
+// Iterative depth-first walk over the AST. Pending nodes are kept on a work
+// stack on the heap, so deep trees (long operator chains, nested blocks) don't
+// consume native stack frames.
+class Traversal {
+public:
+    virtual ~Traversal() = default;
+
+    // Nodes reached by the traversals of the calling thread so far
+    static size_t visitedCount();
+
+protected:
+    void traverse(ASTNode& root);
+
+    // Called when a node is reached; returning false skips its children and postVisit
+    virtual bool preVisit(ASTNode& node);
+    // Next child to descend into, or nullptr once the node is done. `step` starts at
+    // zero and belongs to the hook, which may rewind it to visit children again
+    virtual ASTNode* nextChild(ASTNode& node, size_t& step);
+    // Called after all children of the node have been traversed
+    virtual void postVisit(ASTNode& node);
+
+private:
+    struct Frame {
+        ASTNode *node;
+        size_t step;
+    };
+
+    std::vector<Frame> m_stack;
+};
+
+#endif // TRAVERSAL_HPP
@@ -7,6 +7,7 @@ struct ConstantNode;
 struct BinaryOpNode;
 struct ArrayIndexNode;
 struct AssignmentNode;
+struct UpdateNode;
 struct EmptyStatementNode;
 struct CompoundStatementNode;
 struct ForNode;
@@ -25,6 +26,7 @@ public:
     virtual void visit(BinaryOpNode&) = 0;
     virtual void visit(ArrayIndexNode&) = 0;
     virtual void visit(AssignmentNode&) = 0;
+    virtual void visit(UpdateNode&) = 0;
     virtual void visit(EmptyStatementNode&) = 0;
     virtual void visit(CompoundStatementNode&) = 0;
     virtual void visit(ForNode&) = 0;
@@ -2,24 +2,47 @@
 #define INTERPRETER_HPP
 
 #include "symbol_table.hpp"
+#include "traversal.hpp"
 #include "visitor.hpp"
 
+#include <cstdint>
 #include <iostream>
 #include <format>
 
-class Interpreter : public Visitor {
+// Limits of a run at compile time, consumed as the run goes
+struct EvaluationBudget {
+    uint64_t fuel;   // Nodes evaluated
+    uint64_t memory; // Array elements allocated
+};
+
+// Thrown by a budgeted run which runs out of its budget or reaches a runtime error
+struct EvaluationStopped {
+    const char *reason;
+};
+
+// Expressions leave their values on a value stack; visit methods run once the
+// children of a node have been executed, and loops repeat their children until
+// the condition is false. With a budget, the trace goes to `out` and a runtime
+// error stops the run instead of the program.
+class Interpreter : public Visitor, public Traversal {
 public:
-    explicit Interpreter(const std::string& filepath, SymbolTable& symbolTable);
+    explicit Interpreter(
+        const std::string& filepath, SymbolTable& symbolTable, std::ostream& out = std::cout, EvaluationBudget* budget = nullptr
+    );
 
 public:
     void interprete(ASTNode& root);
 
 private:
+    ASTNode* nextChild(ASTNode& node, size_t& step) override;
+    void postVisit(ASTNode& node) override;
+
     void visit(IdentifierNode&) override;
     void visit(ConstantNode&) override;
     void visit(BinaryOpNode&) override;
     void visit(ArrayIndexNode&) override;
     void visit(AssignmentNode&) override;
+    void visit(UpdateNode&) override;
     void visit(EmptyStatementNode&) override;
     void visit(CompoundStatementNode&) override;
     void visit(ForNode&) override;
@@ -29,6 +52,16 @@ private:
     void visit(MainDeclNode&) override;
     void visit(ProgramNode&) override;
 
+    ASTNode* nextLoopStep(ForNode& node, size_t& step);
+    ASTNode* nextUpdateStep(UpdateNode& node, size_t& step);
+    ValueVariant popValue();
+    size_t elementPosition(ArrayIndexNode& node, const ValueVariant& index);
+    ValueVariant loadElement(Symbol* array, size_t position) const;
+    ValueVariant storeElement(Symbol* array, size_t position, int64_t value);
+
+    void initializeArray(Symbol* array, const InitializerImage* image);
+    void reserveArray(Symbol* array);
+    void allocate(size_t elements);
     void error(const std::string& error, ASTNode* node) const;
     void variantPrinter(const ValueVariant& val) const;
     void performAssignment(Symbol* target, const ValueVariant& rhs);
@@ -39,7 +72,9 @@ private:
     std::string m_filepath;
     SymbolTable& m_symbolTable;
     bool m_isInterpretationEnabled;
-    ValueVariant m_lastExpressionValue;
+    std::vector<ValueVariant> m_values; // Results of the evaluated expressions
+    std::ostream& m_out;
+    EvaluationBudget *m_budget;
 };
 
-#endif // INTERPRETER_HPP
\ No newline at end of file
+#endif // INTERPRETER_HPP
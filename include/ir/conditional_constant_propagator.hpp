@@ -0,0 +1,53 @@
+#ifndef CONDITIONAL_CONSTANT_PROPAGATOR_HPP
+#define CONDITIONAL_CONSTANT_PROPAGATOR_HPP
+
+#include "ir.hpp"
+
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// Sparse conditional constant propagation (Wegman and Zadeck). Every value
+// is assumed constant until proven otherwise and only the edges found to be
+// executable are followed, so constants flowing around loops and through
+// branches on constants are found. Afterwards constant values are replaced
+// by constants, branches on a constant become jumps, the blocks which are
+// never reached are removed and so are the values left unused. Array elements
+// aren't tracked.
+class ConditionalConstantPropagator {
+public:
+    void run(IRFunction& function);
+
+    size_t constantCount() const;
+    size_t foldedBranchCount() const;
+    size_t removedBlockCount() const;
+
+private:
+    struct Lattice {
+        enum State { UNKNOWN, CONSTANT, OVERDEFINED } state = UNKNOWN;
+        int64_t value = 0;
+    };
+
+    void propagate(IRFunction& function);
+    void visit(Instruction& instruction);
+    void markEdge(BasicBlock* from, BasicBlock* to);
+    void update(Instruction& instruction, Lattice value);
+    Lattice valueOf(Instruction* instruction) const;
+
+    void rewrite(IRFunction& function);
+
+private:
+    std::unordered_map<Instruction*, Lattice> m_values;
+    std::unordered_map<Instruction*, std::vector<Instruction*>> m_users;
+    std::unordered_set<BasicBlock*> m_executableBlocks;
+    std::set<std::pair<BasicBlock*, BasicBlock*>> m_executableEdges;
+    std::vector<std::pair<BasicBlock*, BasicBlock*>> m_edgeWorklist;
+    std::vector<Instruction*> m_valueWorklist;
+
+    size_t m_constantCount = 0;
+    size_t m_foldedBranchCount = 0;
+    size_t m_removedBlockCount = 0;
+};
+
+#endif // CONDITIONAL_CONSTANT_PROPAGATOR_HPP
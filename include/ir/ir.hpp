@@ -0,0 +1,91 @@
+#ifndef IR_HPP
+#define IR_HPP
+
+#include "ast.hpp"
+#include "symbol_table.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BasicBlock;
+
+// Operations of the SSA form. Scalar variables become SSA values; arrays stay
+// in memory and are only reached through LOAD, STORE and ARRAY.
+enum class Opcode {
+    CONST,   // Integer constant
+    UNDEF,   // Value of a variable read before it's stored to
+    BINARY,  // `op` over two operands, computed like the Interpreter does
+    CONVERT, // Operand narrowed to the type of the instruction
+    PHI,     // Operand i comes from the predecessor incoming[i]
+    LOAD,    // Element of `array` at the index operand
+    STORE,   // Element of `array` at operand 0 set to operand 1
+    ARRAY,   // Declaration of `array`: the operands are its initializers
+    JUMP,    // To targets[0]
+    BRANCH,  // To targets[0] if the operand isn't zero, to targets[1] otherwise
+    RETURN
+};
+
+struct Instruction {
+    Opcode opcode;
+    ASTNode::DataType type = ASTNode::DataType::UNKNOWN; // Type of the result, UNKNOWN when there's none
+    ASTNode::OperatorType op = ASTNode::OperatorType::ADD;
+    int64_t constant = 0;
+    bool isZeroFilled = false;         // ARRAY: the elements past the initializers are zero
+    Symbol *array = nullptr;           // LOAD, STORE and ARRAY
+    const Symbol *variable = nullptr;  // PHI: the variable being merged
+    std::string name;                  // PHI and the array operations: name of the variable, for the dump
+
+    std::vector<Instruction*> operands;
+    std::vector<BasicBlock*> incoming;
+    std::vector<BasicBlock*> targets;
+
+    BasicBlock *parent = nullptr;
+    size_t id = 0;
+
+    bool isTerminator() const;
+    bool hasResult() const;
+    // Stores, declarations, terminators, and operations which may raise a runtime error
+    bool hasSideEffects() const;
+};
+
+struct BasicBlock {
+    size_t id = 0;
+    std::vector<std::unique_ptr<Instruction>> instructions;
+    std::vector<BasicBlock*> predecessors;
+    std::vector<BasicBlock*> successors;
+
+    // Last instruction, nullptr while the block isn't terminated
+    Instruction* terminator() const;
+};
+
+// The program as a single function in SSA form; the first block is the entry
+class IRFunction {
+public:
+    BasicBlock* createBlock();
+    BasicBlock* entry() const;
+    const std::vector<std::unique_ptr<BasicBlock>>& blocks() const;
+
+    Instruction* append(BasicBlock* block, std::unique_ptr<Instruction> instruction);
+    // Inserted after the phis of the block
+    Instruction* prepend(BasicBlock* block, std::unique_ptr<Instruction> instruction);
+    void erase(Instruction* instruction);
+
+    void addEdge(BasicBlock* from, BasicBlock* to);
+    // Also drops the phi operands coming from `from`
+    void removeEdge(BasicBlock* from, BasicBlock* to);
+    void replaceAllUses(Instruction* from, Instruction* to);
+    // Removes the blocks which can't be reached from the entry; returns how many
+    size_t removeUnreachableBlocks();
+    // Replaces the phis merging a single value (besides themselves) by that value
+    void removeTrivialPhis();
+    // Removes the values without side effects which nothing uses; returns how many
+    size_t removeUnusedValues();
+
+private:
+    std::vector<std::unique_ptr<BasicBlock>> m_blocks;
+    size_t m_nextBlockId = 0;
+    size_t m_nextValueId = 0;
+};
+
+#endif // IR_HPP
@@ -0,0 +1,56 @@
+#ifndef IR_BUILDER_HPP
+#define IR_BUILDER_HPP
+
+#include "ir.hpp"
+#include "traversal.hpp"
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+// Lowers an analyzed program to SSA form, global declarations first, then the
+// body of main. Programs are structured, so the SSA values are built in a
+// single pass: every loop header gets a phi per scalar variable written in the
+// loop, completed once the end of the body is known, and the phis which turn
+// out to merge a single value are removed at the end.
+class IRBuilder : public Traversal {
+public:
+    std::unique_ptr<IRFunction> build(ASTNode& root);
+
+private:
+    struct Loop {
+        BasicBlock *header;
+        BasicBlock *exit;
+        std::vector<Instruction*> phis;
+    };
+
+    bool preVisit(ASTNode& node) override;
+    ASTNode* nextChild(ASTNode& node, size_t& step) override;
+
+    void enterLoop(ForNode& loop);
+    void leaveLoop(ForNode& loop);
+
+    void lowerAssignment(AssignmentNode& node);
+    void lowerVariableDecl(VariableDeclNode& node);
+    void lowerArrayDecl(ArrayDeclNode& node);
+    Instruction* lowerExpression(ExpressionNode& root);
+
+    Instruction* emit(Opcode opcode, ASTNode::DataType type, std::vector<Instruction*> operands);
+    Instruction* constant(int64_t value, ASTNode::DataType type);
+    Instruction* convert(Instruction* value, ASTNode::DataType type);
+    Instruction* undefined(ASTNode::DataType type);
+    void jump(BasicBlock* target);
+
+    Instruction* valueOf(const Symbol* symbol);
+    void declareEvaluated(Symbol* array, const std::string& name);
+
+private:
+    std::unique_ptr<IRFunction> m_function;
+    BasicBlock *m_block = nullptr; // Block the instructions are appended to
+    std::unordered_map<const Symbol*, Instruction*> m_definitions; // Current value of each scalar
+    std::map<ASTNode::DataType, Instruction*> m_undefined;
+    std::unordered_set<const Symbol*> m_declaredArrays;
+    std::vector<Loop> m_loops;
+};
+
+#endif // IR_BUILDER_HPP
@@ -0,0 +1,24 @@
+#ifndef IR_PRINTER_HPP
+#define IR_PRINTER_HPP
+
+#include "ir.hpp"
+
+#include <ostream>
+
+// Textual dump of the IR: a block per label, an instruction per line
+class IRPrinter {
+public:
+    explicit IRPrinter(std::ostream& output);
+
+    void print(const IRFunction& function);
+
+private:
+    void printInstruction(const Instruction& instruction);
+
+    static std::string mnemonic(const Instruction& instruction);
+
+private:
+    std::ostream& m_output;
+};
+
+#endif // IR_PRINTER_HPP
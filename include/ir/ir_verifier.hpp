@@ -0,0 +1,34 @@
+#ifndef IR_VERIFIER_HPP
+#define IR_VERIFIER_HPP
+
+#include "ir.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Checks the invariants the passes rely on: every block ends with its only
+// terminator and its edges match it, phis come first and have an operand per
+// predecessor, operands are well-formed, every value dominates its uses, and
+// every array is declared before it's loaded from or stored to.
+class IRVerifier {
+public:
+    bool verify(const IRFunction& function);
+    const std::vector<std::string>& errors() const;
+
+private:
+    void verifyBlock(const BasicBlock& block);
+    void verifyInstruction(const Instruction& instruction);
+    void verifyDominance(const IRFunction& function);
+    void computeDominators(const IRFunction& function);
+    bool dominates(const BasicBlock* dominator, const BasicBlock* block) const;
+
+    void fail(const BasicBlock& block, const std::string& message);
+
+private:
+    std::vector<std::string> m_errors;
+    std::unordered_map<const Instruction*, size_t> m_positions; // Index of each instruction in its block
+    std::unordered_map<const BasicBlock*, const BasicBlock*> m_idom; // Immediate dominators, the entry maps to itself
+};
+
+#endif // IR_VERIFIER_HPP
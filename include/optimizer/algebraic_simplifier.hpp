@@ -0,0 +1,39 @@
+#ifndef ALGEBRAIC_SIMPLIFIER_HPP
+#define ALGEBRAIC_SIMPLIFIER_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+#include <string>
+#include <vector>
+
+struct RewriteRule {
+    const char *name;
+    // Rewrites the expression owned by the slot in place; true if it changed
+    bool (*apply)(ExpressionSlot& slot);
+};
+
+// Rewrites binary operations bottom-up with the rules of a table until none
+// applies. A rule never changes the type the Analyzer resolved for the
+// expression it replaces, and never drops an operand which may trap.
+class AlgebraicSimplifier : public Traversal {
+public:
+    // Only the named rules run; an empty list enables the whole table
+    explicit AlgebraicSimplifier(const std::vector<std::string>& enabledRules = {});
+
+    void simplify(ASTNode& root);
+
+    static const std::vector<RewriteRule>& rules();
+    size_t rewriteCount() const;
+    size_t rewriteCount(const std::string& ruleName) const;
+
+private:
+    void postVisit(ASTNode& node) override;
+    void simplifySlot(ExpressionSlot& slot);
+
+private:
+    std::vector<bool> m_isRuleEnabled;  // Indexed like rules()
+    std::vector<size_t> m_rewriteCounts;
+};
+
+#endif // ALGEBRAIC_SIMPLIFIER_HPP
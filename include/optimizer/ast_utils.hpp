@@ -0,0 +1,101 @@
+#ifndef AST_UTILS_HPP
+#define AST_UTILS_HPP
+
+#include "ast.hpp"
+#include "symbol_table.hpp"
+
+#include <functional>
+#include <memory>
+#include <unordered_set>
+
+using ExpressionSlot = std::unique_ptr<ExpressionNode>;
+
+// Calls `callback` for every analyzed expression owned directly by `node`,
+// giving the owning pointer so that the expression can be replaced
+void forEachExpressionSlot(ASTNode& node, const std::function<void(ExpressionSlot&)>& callback);
+
+// Integer constant of the given type, placed at the position of `origin`
+std::unique_ptr<ConstantNode> makeConstant(int64_t value, ASTNode::DataType type, const ASTNode& origin);
+
+std::unique_ptr<IdentifierNode> makeIdentifier(Symbol* symbol, const std::string& name, const ASTNode& origin);
+
+std::unique_ptr<BinaryOpNode> makeBinary(
+    ASTNode::OperatorType op, ExpressionSlot left, ExpressionSlot right, ASTNode::DataType type, const ASTNode& origin
+);
+
+std::unique_ptr<AssignmentNode> makeAssignment(ExpressionSlot target, ExpressionSlot value, const ASTNode& origin);
+
+// Declaration of a new compiler temporary, named "<prefix>.<n>", initialized with `init`
+std::unique_ptr<VariableDeclNode> declareTemporary(
+    SymbolTable& symbolTable, const std::string& prefix, ASTNode::DataType type, ExpressionSlot init, const ASTNode& origin
+);
+
+// Source text of an analyzed expression for remarks, cut after 64 characters; nested
+// operations are parenthesized
+std::string expressionText(const ExpressionNode* node);
+
+// Deep copy of an analyzed expression
+ExpressionSlot cloneExpression(const ExpressionNode* node);
+
+// Deep copy of an analyzed statement; nullptr for array and type declarations, which aren't copied
+std::unique_ptr<StatementNode> cloneStatement(const StatementNode* node);
+
+// Symbols declared or stored to anywhere inside `node`; an element store counts for the whole array
+void collectWrittenSymbols(ASTNode& node, std::unordered_set<Symbol*>& written);
+
+// Header of a loop `for (...; v cmp N; v = v + step)` with a constant N, whose
+// variable v is a scalar or an element with a constant index within bounds
+struct CountedLoop {
+    ExpressionNode *variable; // Target of the increment
+    Symbol *symbol;           // The variable, or the array holding it
+    int64_t step;             // Non-zero, negative for a decreasing variable
+    int64_t last;             // Bound of the values the body runs with, inclusive
+};
+
+// Matches the header only, the body isn't inspected. The variable never wraps
+// around: its value after the last increment still fits its type.
+bool matchCountedLoop(ForNode& loop, CountedLoop& counted);
+
+// Number of iterations of a counted loop whose init stores a constant to the variable
+bool countIterations(const ForNode& loop, const CountedLoop& counted, int64_t& first, uint64_t& count);
+
+// True for a counted loop whose body is known to run at least once
+bool runsAtLeastOnce(ForNode& loop);
+
+// Values the variable of a counted loop takes in the body, ends included
+struct LoopRange {
+    int64_t first;
+    int64_t last;
+};
+
+// Range of a counted loop whose body runs at least once
+bool loopRange(const ForNode& loop, const CountedLoop& counted, LoopRange& range);
+
+// Matches `c * v + d` made of constants, the variable v, +, - and * by a constant.
+// With a range, every operation must also stay within its type for all values of v.
+bool matchAffine(
+    const ExpressionNode* root, const ExpressionNode* variable, int64_t& coefficient, int64_t& constant,
+    const LoopRange* range = nullptr
+);
+
+// Marks every read of a variable or an element under `root` with whether it is
+// proven to find a value: the statements before it initialize the variable on
+// every path. A loop may run zero times, so what its body initializes counts
+// after it only when the loop surely runs. Stores are marked too, they don't
+// read. Nodes made afterwards stay unproven until the next call, which a pass
+// relying on mayTrap makes before it starts.
+void markInitializedReads(ASTNode& root);
+
+// Structural equality of two analyzed expressions; identifiers are compared by symbol
+bool isSameExpression(const ExpressionNode* lhs, const ExpressionNode* rhs);
+
+// True if evaluating the expression can raise a runtime error: a division or a
+// shift by an operand that isn't a safe constant, an array access whose index
+// isn't a constant within bounds, or a read of a variable or an element which
+// markInitializedReads didn't prove initialized. Compiler temporaries are
+// always initialized by their declaration.
+bool mayTrap(const ExpressionNode* node);
+// The same, not counting the operands of the expression
+bool mayTrapItself(const ExpressionNode* node);
+
+#endif // AST_UTILS_HPP
@@ -0,0 +1,67 @@
+#ifndef BOUNDS_CHECK_ELIMINATOR_HPP
+#define BOUNDS_CHECK_ELIMINATOR_HPP
+
+#include "traversal.hpp"
+#include "symbol_table.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Interval analysis of the scalar variables, run forward over the statements.
+// Every array access whose index is proven within bounds is marked so that the
+// Interpreter skips the check; an access whose index is proven out of bounds
+// gets a warning, as it fails whenever it's executed.
+//
+// A loop body is analyzed once, with every variable written in the loop
+// unknown; the variable of a counted loop `for (...; i < N; i = i + c)` is
+// bounded by its initial value and N instead.
+//
+// The values stored to every array are bounded the same way; narrowArrays()
+// then packs each array whose values all fit a narrower integer type in it.
+class BoundsCheckEliminator : public Traversal {
+public:
+    explicit BoundsCheckEliminator(const std::string& filepath);
+
+    void eliminate(ASTNode& root);
+    size_t eliminatedCount() const;
+    size_t failingCount() const;
+
+    // Returns the number of arrays narrowed
+    size_t narrowArrays();
+
+private:
+    struct Interval {
+        int64_t lo, hi;
+    };
+
+    using State = std::unordered_map<const Symbol*, Interval>; // Missing symbols are unknown
+
+    bool preVisit(ASTNode& node) override;
+    ASTNode* nextChild(ASTNode& node, size_t& step) override;
+    void postVisit(ASTNode& node) override;
+
+    void enterLoop(ForNode& loop);
+    void assign(const Symbol* symbol, Interval value);
+    void forgetElements(const Symbol* array);
+    void store(Symbol* array, Interval value);
+    Interval evaluate(ExpressionNode& root);
+    Interval evaluateOperator(ASTNode::OperatorType op, Interval lhs, Interval rhs, ASTNode::DataType type) const;
+    void checkIndex(ArrayIndexNode& node, Interval index);
+    Interval rangeOf(const Symbol* symbol) const;
+
+    static Interval typeRange(ASTNode::DataType type);
+
+private:
+    std::string m_filepath;
+    State m_state;
+    std::vector<State> m_statesAfterLoops; // State after each loop being analyzed
+    size_t m_eliminatedCount = 0;
+    size_t m_failingCount = 0;
+
+    // Values stored to each declared array, by its initializers or assignments, and its declarations
+    std::unordered_map<Symbol*, Interval> m_storedValues;
+    std::vector<std::pair<Symbol*, ArrayDeclNode*>> m_arrayDeclarations;
+};
+
+#endif // BOUNDS_CHECK_ELIMINATOR_HPP
@@ -0,0 +1,29 @@
+#ifndef CLOSED_FORM_EVALUATOR_HPP
+#define CLOSED_FORM_EVALUATOR_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+// Replaces counted loops with a constant trip count, whose body only performs
+// reductions `s = s + e` with e affine in the loop variable, by
+// their closed-form result:
+//     s = s + (a * (n * v0 + step * n * (n - 1) / 2) + n * b)  for e = a * v + b
+//     v = v0 + n * step
+// The sums are computed modulo 2^64 and narrowed by the store, which gives the
+// same value as n wrapping additions, as long as no operation in e is narrower
+// than s or the range of v proves that it never wraps. The initial store of the
+// loop is kept.
+class ClosedFormEvaluator : public Traversal {
+public:
+    void evaluate(ASTNode& root);
+    size_t replacedCount() const;
+
+private:
+    void postVisit(ASTNode& node) override;
+    void replace(std::unique_ptr<StatementNode>& slot);
+
+private:
+    size_t m_replacedCount = 0;
+};
+
+#endif // CLOSED_FORM_EVALUATOR_HPP
@@ -0,0 +1,21 @@
+#ifndef CONSTANT_FOLDER_HPP
+#define CONSTANT_FOLDER_HPP
+
+#include "traversal.hpp"
+
+// Replaces every binary operation over constants with a typed constant. The
+// value is computed with the width and wrap-around of the type the Analyzer
+// resolved; operations which trap (division by zero) are left for runtime.
+class ConstantFolder : public Traversal {
+public:
+    void fold(ASTNode& root);
+    size_t foldedCount() const;
+
+private:
+    void postVisit(ASTNode& node) override;
+
+private:
+    size_t m_foldedCount = 0;
+};
+
+#endif // CONSTANT_FOLDER_HPP
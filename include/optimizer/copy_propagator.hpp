@@ -0,0 +1,94 @@
+#ifndef COPY_PROPAGATOR_HPP
+#define COPY_PROPAGATOR_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Forward dataflow over the statements of blocks and loop bodies:
+//  - after `x = y`, reads of x use y until either of them is written again,
+//  - after `x = a[i]` (or `a[i] = x`), reads of a[i] use x until x, i or a is
+//    written again,
+//  - an element read twice with nothing written in between is loaded once into
+//    a compiler temporary, declared right before the statement of the first read.
+// Only copies of the same type are used, so that no conversion is skipped. A
+// loop is entered with the facts none of its statements invalidate, and left
+// with the same facts. A first read is only moved ahead of its statement when
+// nothing evaluated before it there can raise a runtime error.
+class CopyPropagator : public Traversal {
+public:
+    explicit CopyPropagator(SymbolTable& symbolTable);
+
+    void propagate(ASTNode& root);
+
+    size_t propagatedCount() const;
+    size_t eliminatedLoadCount() const;
+
+private:
+    // A block being processed and the temporaries to declare in it
+    struct Frame {
+        CompoundStatementNode *compound;
+        std::unordered_set<Symbol*> declared;
+        std::vector<std::pair<StatementNode*, std::unique_ptr<StatementNode>>> insertions;
+    };
+
+    // The value of `target` is the value of `source`
+    struct Copy {
+        Symbol *target;
+        Symbol *source;
+        std::string sourceName;
+    };
+
+    // An element read whose value is available in `holder`, or only its first read so far
+    struct Load {
+        const ArrayIndexNode *pattern;
+        std::vector<Symbol*> reads; // The array and the symbols of the index
+        Symbol *holder = nullptr;
+        std::string holderName;
+
+        // The first read, while it can still be moved into a temporary
+        ExpressionSlot *firstSlot = nullptr;
+        Frame *frame = nullptr;
+        StatementNode *statement = nullptr;
+    };
+
+    struct Facts {
+        std::vector<Copy> copies;
+        std::vector<Load*> loads;
+    };
+
+    bool preVisit(ASTNode& node) override;
+    ASTNode* nextChild(ASTNode& node, size_t& step) override;
+    void postVisit(ASTNode& node) override;
+
+    void processAssignment(AssignmentNode& node, Frame* frame, StatementNode* statement);
+    void processDeclaration(DeclarationNode& node, Frame* frame, StatementNode* statement);
+    void rewrite(ExpressionSlot& root, bool& isTrapSeen, Frame* frame, StatementNode* statement);
+    bool rewriteLoad(ExpressionSlot& slot, bool isTrapBefore, Frame* frame, StatementNode* statement);
+    void hoist(Load& load);
+
+    Load* recordLoad(const ArrayIndexNode& pattern);
+    void generate(Symbol* target, const std::string& targetName, ExpressionNode& value);
+    void kill(Symbol* symbol);
+    void killElementStore(const ArrayIndexNode& element);
+
+private:
+    SymbolTable& m_symbolTable;
+    size_t m_propagatedCount = 0;
+    size_t m_eliminatedLoadCount = 0;
+
+    Facts m_facts;
+    std::vector<Facts> m_loopFacts; // Facts at the headers of the enclosing loops
+    std::vector<std::unique_ptr<Frame>> m_frames;
+    std::vector<std::unique_ptr<Load>> m_loads;
+
+    // Block and statement of the statement about to be visited, if it's directly in a block
+    Frame *m_statementFrame = nullptr;
+    StatementNode *m_statement = nullptr;
+};
+
+#endif // COPY_PROPAGATOR_HPP
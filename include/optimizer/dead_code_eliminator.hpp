@@ -0,0 +1,49 @@
+#ifndef DEAD_CODE_ELIMINATOR_HPP
+#define DEAD_CODE_ELIMINATOR_HPP
+
+#include "traversal.hpp"
+#include "symbol_table.hpp"
+
+#include <string_view>
+#include <unordered_set>
+
+// Numbers of statements removed, by the reason they were dead for
+struct DeadCodeReport {
+    size_t emptyStatements = 0;
+    size_t emptyBlocks = 0;
+    size_t unreachableStatements = 0; // Following a loop without a condition
+    size_t unusedDeclarations = 0;
+    size_t deadStores = 0;            // Assignments to variables which are never read
+};
+
+// Prunes statements which can't affect the program. Declarations of unread
+// variables and stores to them are removed only when evaluating their value
+// can't raise a runtime error, and a declaration stays as long as a store to
+// it does. Removing one may leave others unread, so the pass repeats until
+// nothing changes.
+class DeadCodeEliminator : public Traversal {
+public:
+    void eliminate(ASTNode& root);
+    const DeadCodeReport& report() const;
+
+private:
+    void postVisit(ASTNode& node) override;
+
+    template<typename Statement>
+    void prune(std::vector<std::unique_ptr<Statement>>& statements);
+
+    bool isDead(ASTNode& statement);
+    bool isDeadStore(const AssignmentNode* assignment) const;
+
+    void remarkDeadStore(const AssignmentNode& assignment) const;
+    // Reports an unused declaration kept for its initializer or a store; always false
+    bool keepTrapping(const IdentifierNode& declared, std::string_view reason) const;
+
+private:
+    DeadCodeReport m_report;
+    std::unordered_set<const Symbol*> m_readSymbols;
+    std::unordered_set<const Symbol*> m_storedSymbols; // Targets of stores which may trap
+    bool m_isChanged = false; // A declaration, a store or an unreachable statement was removed in this round
+};
+
+#endif // DEAD_CODE_ELIMINATOR_HPP
@@ -0,0 +1,48 @@
+#ifndef DEAD_STORE_ELIMINATOR_HPP
+#define DEAD_STORE_ELIMINATOR_HPP
+
+#include "ast.hpp"
+#include "symbol_table.hpp"
+
+#include <set>
+#include <string>
+#include <utility>
+
+// Removes stores which are overwritten before any read. Statements are scanned
+// backwards while tracking the locations (scalars and constant-index elements)
+// that are certainly written again before they are read. A loop may run any
+// number of times, so everything it reads stays live across it.
+//
+// A removed store is replaced with an empty statement carrying its trace line,
+// which the Interpreter prints. Stores whose right side can raise a runtime
+// error are kept. The values variables hold when the program ends are its
+// result, so nothing is dead at the end of main.
+class DeadStoreEliminator {
+public:
+    void eliminate(ASTNode& root);
+    size_t removedCount() const;
+
+private:
+    // Array symbol and element index, or a scalar symbol and -1
+    using Location = std::pair<const Symbol*, int64_t>;
+
+    // Statements still to scan, from the last one towards `begin`
+    struct Frame {
+        std::unique_ptr<StatementNode>* begin;
+        size_t remaining;
+        ForNode *loop;                // Loop whose body is scanned, nullptr for a block
+        std::set<Location> deadAfter; // Dead locations before the loop's body is entered
+    };
+
+    void scan(CompoundStatementNode& body);
+    void scanStatement(std::unique_ptr<StatementNode>& slot, std::vector<Frame>& frames);
+    void scanStore(AssignmentNode& assignment, std::unique_ptr<StatementNode>* slot);
+    void markRead(ASTNode& node);
+    void remove(std::unique_ptr<StatementNode>& slot, const Symbol* symbol, const std::string& trace);
+
+private:
+    std::set<Location> m_dead;
+    size_t m_removedCount = 0;
+};
+
+#endif // DEAD_STORE_ELIMINATOR_HPP
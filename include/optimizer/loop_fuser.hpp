@@ -0,0 +1,37 @@
+#ifndef LOOP_FUSER_HPP
+#define LOOP_FUSER_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+#include <unordered_set>
+
+// Merges adjacent loops with the same header over a scalar variable:
+//     for (h) b1; for (h) b2;  ->  for (h) { b1; b2 }
+// Both loops run the same iterations when the variable is only written by the
+// header and the header reads nothing else either body writes. The fused loop
+// runs b2 of iteration q before b1 of any later iteration p, which is allowed when:
+//  - no scalar written by one body is used by the other,
+//  - no element accessed by b2 in iteration q is stored to by b1 in an iteration
+//    p > q, or the other way around. Subscripts c * v + d are compared exactly;
+//    an array is left alone when it's stored to and a subscript isn't of that form,
+//  - neither body can raise a runtime error, which would stop the program after
+//    a different set of iterations. In a counted loop with a constant trip count,
+//    accesses whose subscript stays within bounds for every value of v can't,
+//  - at most one body prints to the trace, which would otherwise interleave the
+//    lines of both loops. The lines of the header only lose repetitions.
+class LoopFuser : public Traversal {
+public:
+    void fuse(ASTNode& root);
+    size_t fusedCount() const;
+
+private:
+    void postVisit(ASTNode& node) override;
+    bool tryFuse(ForNode& first, ForNode& second);
+
+private:
+    size_t m_fusedCount = 0;
+    std::unordered_set<StatementNode*> m_fusedBodies;
+};
+
+#endif // LOOP_FUSER_HPP
@@ -0,0 +1,43 @@
+#ifndef LOOP_INVARIANT_MOVER_HPP
+#define LOOP_INVARIANT_MOVER_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+#include <unordered_set>
+#include <vector>
+
+// Moves the largest loop-invariant operations and element reads of a loop into
+// compiler temporaries evaluated once, right after the loop's initial store:
+//     { init; T t = e; for (; cond[e := t]; inc[e := t]) body[e := t] }
+// An expression is invariant when no symbol it reads is written in the loop.
+// Expressions of the body and the increment are moved only out of a counted
+// loop which surely runs, and only when they can't trap: the statements of the
+// body before them still run first. The condition is always evaluated, so its
+// invariants are moved out of any loop, including the first one that may trap;
+// the error is raised at the same point with the same message.
+// Inner loops are processed first, so their invariants can move further out.
+class LoopInvariantMover : public Traversal {
+public:
+    explicit LoopInvariantMover(SymbolTable& symbolTable);
+
+    void hoist(ASTNode& root);
+    size_t hoistedCount() const;
+
+private:
+    void postVisit(ASTNode& node) override;
+
+    void hoistFrom(std::unique_ptr<StatementNode>& slot);
+    void collectInvariants(ExpressionSlot& root, bool isConditionRoot);
+
+private:
+    SymbolTable& m_symbolTable;
+    size_t m_hoistedCount = 0;
+
+    // State of the loop being processed
+    const ForNode *m_loop = nullptr;
+    std::unordered_set<Symbol*> m_written;
+    std::vector<ExpressionSlot*> m_candidates;
+};
+
+#endif // LOOP_INVARIANT_MOVER_HPP
@@ -0,0 +1,36 @@
+#ifndef LOOP_UNROLLER_HPP
+#define LOOP_UNROLLER_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+// Unrolls counted loops with a constant trip count whose body doesn't write
+// the loop variable. Sizes are counted in AST nodes:
+//  - when all the iterations fit in the budget, the loop is replaced by a copy
+//    of the body per iteration, with the variable substituted by its value,
+//    each followed by a constant store of the variable; the copies are folded.
+//  - otherwise the body is repeated k times per test of the condition, with
+//    the increment between the copies, and the n % k remaining iterations are
+//    unrolled after the loop. k is chosen so both parts fit the budget.
+class LoopUnroller : public Traversal {
+public:
+    explicit LoopUnroller(size_t budget);
+
+    void unroll(ASTNode& root);
+    size_t fullCount() const;
+    size_t partialCount() const;
+
+private:
+    void postVisit(ASTNode& node) override;
+    void unrollLoop(std::unique_ptr<StatementNode>& slot);
+
+    // Copy of `body` run with the variable equal to `value`, then the store of the next value
+    void appendIteration(CompoundStatementNode& block, const StatementNode& body, const CountedLoop& counted, int64_t value);
+
+private:
+    size_t m_budget;
+    size_t m_fullCount = 0;
+    size_t m_partialCount = 0;
+};
+
+#endif // LOOP_UNROLLER_HPP
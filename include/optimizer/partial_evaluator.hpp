@@ -0,0 +1,37 @@
+#ifndef PARTIAL_EVALUATOR_HPP
+#define PARTIAL_EVALUATOR_HPP
+
+#include "ast.hpp"
+#include "interpreter.hpp"
+#include "symbol_table.hpp"
+
+#include <string>
+
+// Programs take no input, so the Interpreter can run them at compile time.
+// The global declarations and the statements of main are run one by one with
+// a budget; the ones which complete are replaced with the trace they printed,
+// kept in a single empty statement, and the values they left stay in their
+// symbols. The run stops at the first statement which runs out of fuel or
+// memory, or raises a runtime error; that statement and the ones after it are
+// left for the actual run, which starts from the values left by the ones before.
+class PartialEvaluator {
+public:
+    PartialEvaluator(const std::string& filepath, SymbolTable& symbolTable, EvaluationBudget budget);
+
+    void evaluate(ProgramNode& root);
+
+    size_t evaluatedCount() const;
+    size_t statementCount() const;
+    uint64_t fuelUsed() const;
+
+private:
+    std::string m_filepath;
+    SymbolTable& m_symbolTable;
+    EvaluationBudget m_budget;
+
+    size_t m_evaluatedCount = 0;
+    size_t m_statementCount = 0;
+    uint64_t m_fuelUsed = 0;
+};
+
+#endif // PARTIAL_EVALUATOR_HPP
@@ -0,0 +1,62 @@
+#ifndef PASS_MANAGER_HPP
+#define PASS_MANAGER_HPP
+
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// A transformation registered by name; `run` applies it to whatever it was
+// bound to and returns the number of changes it made
+struct Pass {
+    std::string name;
+    unsigned level;                        // Lowest -O level which runs the pass, 0 if only run on request
+    std::vector<std::string> dependencies; // Selected along with the pass, and registered before it
+    std::vector<std::string> invalidates;  // Passes to run again once this one changes something
+    bool isIterated;                       // Part of the fixed point, otherwise run once after it
+    std::function<size_t()> run;
+};
+
+struct PassStatistics {
+    std::string name;
+    size_t runCount = 0;
+    double milliseconds = 0;
+    // AST nodes reached by the Traversals of the pass. Walks of their own, like the
+    // interval of a subscript in bounds checking, and IR passes aren't counted
+    size_t visitedCount = 0;
+    size_t changeCount = 0;
+};
+
+// Runs the selected passes in the order they were registered. The iterated
+// ones repeat, each only while a pass run after it last changed something it
+// invalidates, until none is left to run or the budget of rounds is spent;
+// the others run once afterwards.
+class PassManager {
+public:
+    explicit PassManager(size_t roundBudget);
+
+    void add(Pass pass);
+    bool contains(const std::string& name) const;
+    // Selects the passes of the level and the named ones, with their dependencies;
+    // names registered elsewhere are left to their own manager
+    void select(unsigned level, const std::vector<std::string>& names);
+
+    void run();
+
+    size_t roundCount() const;
+    // Passes which ran, in the order they were registered
+    std::vector<PassStatistics> statistics() const;
+
+private:
+    const Pass* find(const std::string& name) const;
+    void execute(size_t index);
+
+private:
+    size_t m_roundBudget;
+    size_t m_roundCount = 0;
+    std::vector<Pass> m_passes;
+    std::vector<PassStatistics> m_statistics; // Indexed like m_passes
+    std::unordered_set<std::string> m_selected;
+};
+
+#endif // PASS_MANAGER_HPP
@@ -0,0 +1,39 @@
+#ifndef REMARKS_HPP
+#define REMARKS_HPP
+
+#include "ast.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A transformation a pass applied, or one it considered and missed, with the reason
+struct Remark {
+    enum class Kind { APPLIED, MISSED };
+
+    Kind kind;
+    std::string pass;
+    size_t line, column;
+    std::string message;
+};
+
+// Remarks of the passes, written out by --remarks. The pass manager names the
+// pass being run. Nothing is recorded until recording is enabled, so a message
+// costlier to build than a literal is guarded by isEnabled(); a remark repeated
+// by a pass run again on its own output is kept once.
+class Remarks {
+public:
+    static void enable();
+    static bool isEnabled();
+    static void setPass(const std::string& name);
+
+    static void applied(const ASTNode& node, const std::string& message);
+    static void missed(const ASTNode& node, const std::string& message);
+
+    // In the order they were made
+    static const std::vector<Remark>& all();
+    // JSON array of the remarks, an object per remark
+    static void write(std::ostream& out);
+};
+
+#endif // REMARKS_HPP
@@ -0,0 +1,39 @@
+#ifndef SCALAR_REPLACER_HPP
+#define SCALAR_REPLACER_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+#include <map>
+#include <unordered_set>
+
+// Promotes the elements of an array to scalar variables when every access to
+// the array uses a constant index within bounds: `a[2]` becomes an identifier
+// of its own symbol, named "a[2]", so that traces and diagnostics still show
+// the element. The array keeps its declaration, which initializes the promoted
+// elements; the symbols record which array and index they stand for.
+class ScalarReplacer : public Traversal {
+public:
+    explicit ScalarReplacer(SymbolTable& symbolTable);
+
+    void replace(ASTNode& root);
+    size_t promotedCount() const;
+    size_t arrayCount() const;
+
+private:
+    bool preVisit(ASTNode& node) override;
+    void postVisit(ASTNode& node) override;
+
+    Symbol* elementSymbol(Symbol* array, int64_t index);
+
+private:
+    SymbolTable& m_symbolTable;
+    size_t m_promotedCount = 0;
+    size_t m_arrayCount = 0;
+
+    bool m_isCollecting = false;
+    std::unordered_set<Symbol*> m_disqualified;
+    std::map<std::pair<Symbol*, int64_t>, Symbol*> m_elements;
+};
+
+#endif // SCALAR_REPLACER_HPP
@@ -0,0 +1,61 @@
+#ifndef STORAGE_ALLOCATOR_HPP
+#define STORAGE_ALLOCATOR_HPP
+
+#include "traversal.hpp"
+#include "symbol_table.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+// Shares storage between block-scoped variables whose lifetimes don't overlap,
+// like a register allocator for the memory of the frame. A variable declared in
+// a block lives from its declaration to the end of the last statement of that
+// block which uses it; the variables of main itself are the result of the
+// program and live until its end, globals are left alone. The lifetimes are
+// colored in the order they start, scalars and arrays apart (arrays of each
+// storage type apart as well), and every symbol of a slot reads and writes the
+// storage of its first one. A declaration always initializes its storage
+// again, so nothing leaks from one to the next.
+class StorageAllocator : public Traversal {
+public:
+    void allocate(ASTNode& root);
+
+    size_t declarationCount() const;
+    size_t slotCount() const;
+
+private:
+    // A block being walked and the statement of it being walked
+    struct Frame {
+        CompoundStatementNode *compound;
+        ASTNode *statement = nullptr;
+    };
+
+    struct Lifetime {
+        Symbol *symbol;
+        const IdentifierNode *declaration; // First declaration of the symbol, for remarks
+        size_t first;
+        size_t depth;            // Frame of the block which declares the symbol
+        ASTNode *lastStatement;  // Statement of that block, or the block, which ends the lifetime
+        size_t last = 0;
+    };
+
+    bool preVisit(ASTNode& node) override;
+    ASTNode* nextChild(ASTNode& node, size_t& step) override;
+    void postVisit(ASTNode& node) override;
+
+    void declare(const IdentifierNode& identifier);
+    void assignSlots(bool isArray);
+
+private:
+    size_t m_declarationCount = 0;
+    size_t m_slotCount = 0;
+
+    size_t m_position = 0; // Preorder number of the node being visited
+    CompoundStatementNode *m_mainBody = nullptr;
+    std::vector<Frame> m_frames;
+    std::vector<Lifetime> m_lifetimes;
+    std::unordered_map<Symbol*, size_t> m_lifetimeOf;
+    std::unordered_map<ASTNode*, size_t> m_ends; // Last preorder number inside a statement of a block
+};
+
+#endif // STORAGE_ALLOCATOR_HPP
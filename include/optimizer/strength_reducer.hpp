@@ -0,0 +1,36 @@
+#ifndef STRENGTH_REDUCER_HPP
+#define STRENGTH_REDUCER_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+// Replaces expensive arithmetic with cheaper equivalents of the same value:
+//  - i * stride inside a counted loop which surely runs becomes a temporary
+//    updated by addition, when the stride is a constant or an initialized variable,
+//  - x * 2^k becomes x << k,
+//  - x / d and x % d by a constant get a multiply-high (or shift) plan which the
+//    Interpreter uses instead of a division.
+class StrengthReducer : public Traversal {
+public:
+    explicit StrengthReducer(SymbolTable& symbolTable);
+
+    void reduce(ASTNode& root);
+
+    size_t inductionCount() const;
+    size_t shiftCount() const;
+    size_t divisionCount() const;
+
+private:
+    bool preVisit(ASTNode& node) override;
+    void postVisit(ASTNode& node) override;
+
+    void reduceInduction(std::unique_ptr<StatementNode>& slot);
+
+private:
+    SymbolTable& m_symbolTable;
+    size_t m_inductionCount = 0;
+    size_t m_shiftCount = 0;
+    size_t m_divisionCount = 0;
+};
+
+#endif // STRENGTH_REDUCER_HPP
@@ -0,0 +1,27 @@
+#ifndef UPDATE_FUSER_HPP
+#define UPDATE_FUSER_HPP
+
+#include "traversal.hpp"
+#include "ast_utils.hpp"
+
+// Turns the assignments `x = x op e` and `a[i] = a[i] op e` into updates, whose
+// target is evaluated once: the Interpreter reads the element and stores the
+// result through the same index. Only the operation's left operand is matched,
+// so the operands keep their order of evaluation. Runs after the other passes,
+// which see an update as the assignment it was.
+class UpdateFuser : public Traversal {
+public:
+    void fuse(ASTNode& root);
+    size_t fusedCount() const;
+
+private:
+    void postVisit(ASTNode& node) override;
+
+    template<typename Statement>
+    void fuseStatement(std::unique_ptr<Statement>& slot);
+
+private:
+    size_t m_fusedCount = 0;
+};
+
+#endif // UPDATE_FUSER_HPP
@@ -1,15 +1,200 @@
 #include "analyzer.hpp"
+#include "arithmetic.hpp"
 
+#include <algorithm>
 #include <format>
 #include <iostream>
 
-Analyzer::Analyzer(const std::string& path) : m_filePath(path) {}
+namespace {
+
+// Counts the statements of every block and loop in one walk, a block after its children
+class StatementCounter : public Traversal {
+public:
+    explicit StatementCounter(std::unordered_map<const StatementNode*, size_t>& counts) : m_counts(counts) {}
+
+    void count(ASTNode& root) { traverse(root); }
+
+private:
+    // Expressions hold no statements
+    bool preVisit(ASTNode& node) override {
+        return dynamic_cast<ExpressionNode*>(&node) == nullptr;
+    }
+
+    void postVisit(ASTNode& node) override {
+        if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+            size_t count = 1;
+            for (auto& child : compound->statements) {
+                count += countOf(child.get());
+            }
+            m_counts[compound] = count;
+        } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+            m_counts[forNode] = 1 + (forNode->body ? countOf(forNode->body.get()) : 0);
+        }
+    }
+
+    size_t countOf(const StatementNode* statement) const {
+        auto found = m_counts.find(statement);
+        return found != m_counts.end() ? found->second : 1;
+    }
+
+    std::unordered_map<const StatementNode*, size_t>& m_counts;
+};
+
+} // namespace
+
+Analyzer::Analyzer(const std::string& path, size_t jobs) : m_filePath(path) {
+    if (jobs > 1) {
+        m_pool = std::make_unique<ThreadPool>(jobs);
+        m_isCollectingDiagnostics = true;
+    }
+}
+
+Analyzer::Analyzer(const std::string& path, std::shared_ptr<const ScopeSnapshot> outerScope) :
+    m_symbolTable(std::move(outerScope)),
+    m_filePath(path),
+    m_isCollectingDiagnostics(true)
+{}
 
 SymbolTable& Analyzer::analyze(ASTNode& root) {
-    root.accept(*this);
+    if (!m_pool) {
+        traverse(root);
+        return m_symbolTable;
+    }
+
+    StatementCounter(m_statementCounts).count(root);
+    std::optional<Diagnostic> failure;
+
+    try {
+        traverse(root);
+    } catch (const Diagnostic& diagnostic) {
+        failure = diagnostic;
+    } catch (...) {
+        // The workers still reference this analyzer
+        m_pool->wait();
+        throw;
+    }
+
+    m_pool->wait();
+    reportDiagnostics(std::move(failure));
+
     return m_symbolTable;
 }
 
+bool Analyzer::isParallelCandidate(StatementNode* statement) const {
+    // Blocks and loops neither declare nor modify anything in the enclosing scope
+    if (!dynamic_cast<CompoundStatementNode*>(statement) && !dynamic_cast<ForNode*>(statement)) {
+        return false;
+    }
+
+    auto found = m_statementCounts.find(statement);
+    return found != m_statementCounts.end() && found->second >= PARALLEL_MIN_STATEMENTS;
+}
+
+void Analyzer::dispatch(StatementNode& block) {
+    SiblingTask& task = m_tasks.emplace_back();
+    task.block = &block;
+
+    // The snapshot freezes the names visible right here, later declarations stay invisible
+    m_pool->submit([this, &task, outerScope = m_symbolTable.snapshot()] {
+        Analyzer worker(m_filePath, outerScope);
+
+        try {
+            worker.traverse(*task.block);
+        } catch (const Diagnostic& diagnostic) {
+            task.diagnostic = diagnostic;
+        } catch (...) {
+            task.exception = std::current_exception();
+        }
+
+        task.symbolTable.adopt(std::move(worker.m_symbolTable));
+    });
+}
+
+void Analyzer::reportDiagnostics(std::optional<Diagnostic> failure) {
+    std::vector<Diagnostic> diagnostics;
+
+    // A failure other than a diagnostic goes to the caller, as in a sequential analysis
+    for (auto& task : m_tasks) {
+        if (task.exception) std::rethrow_exception(task.exception);
+    }
+
+    for (auto& task : m_tasks) {
+        if (task.diagnostic) diagnostics.push_back(*task.diagnostic);
+
+        // Symbols declared by the workers are referenced from the AST
+        m_symbolTable.adopt(std::move(task.symbolTable));
+    }
+
+    if (failure) diagnostics.push_back(*failure);
+    if (diagnostics.empty()) return;
+
+    std::stable_sort(diagnostics.begin(), diagnostics.end(), [](const Diagnostic& lhs, const Diagnostic& rhs) {
+        return lhs.line != rhs.line ? lhs.line < rhs.line : lhs.column < rhs.column;
+    });
+
+    for (const auto& diagnostic : diagnostics) {
+        std::cerr << std::format(
+            "{}:{}:{}: semantic error: {}\n", m_filePath, diagnostic.line, diagnostic.column, diagnostic.message
+        );
+    }
+
+    exit(EXIT_FAILURE);
+}
+
+bool Analyzer::preVisit(ASTNode& node) {
+    if (dynamic_cast<CompoundStatementNode*>(&node) || dynamic_cast<ForNode*>(&node)) {
+        m_symbolTable.enterScope();
+    } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+        checkDeclaredName(varDecl->identifier->name, varDecl);
+    } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+        checkDeclaredName(arrayDecl->identifier->name, arrayDecl);
+    } else if (auto mainDecl = dynamic_cast<MainDeclNode*>(&node)) {
+        if (m_symbolTable.lookupSymbol("main") != nullptr) {
+            error("main function is already declared", mainDecl);
+        }
+
+        Symbol newSymbol;
+        newSymbol.isArray = false;
+        newSymbol.isTypedef = false;
+        newSymbol.declarationNode = mainDecl;
+        newSymbol.type = ASTNode::DataType::INT;
+
+        m_symbolTable.declare("main", std::move(newSymbol));
+    }
+
+    return true;
+}
+
+ASTNode* Analyzer::nextChild(ASTNode& node, size_t& step) {
+    // Large sibling blocks go to the thread pool instead of being descended into
+    if (m_pool && dynamic_cast<CompoundStatementNode*>(&node)) {
+        ASTNode* child = node.child(step++);
+
+        while (child && isParallelCandidate(static_cast<StatementNode*>(child))) {
+            dispatch(*static_cast<StatementNode*>(child));
+            child = node.child(step++);
+        }
+
+        return child;
+    }
+
+    return node.child(step++);
+}
+
+void Analyzer::postVisit(ASTNode& node) {
+    node.accept(*this);
+}
+
+void Analyzer::checkDeclaredName(const std::string& name, ASTNode* node) {
+    if (!m_symbolTable.isUniqueInCurrentScope(name)) {
+        error("redeclaration of '" + name + "'", node);
+    }
+
+    if (Symbol* symbol = m_symbolTable.lookupSymbol(name)) {
+        if (symbol->isTypedef) error("typename '" + name + "' was used as a variable name", node);
+    }
+}
+
 // *
 void Analyzer::visit(IdentifierNode& node) {
     Symbol *symbol = m_symbolTable.lookupSymbol(node.name);
@@ -49,9 +234,6 @@ void Analyzer::visit(ConstantNode& node) {
 
 // *
 void Analyzer::visit(BinaryOpNode& node) {
-    node.left->accept(*this);
-    node.right->accept(*this);
-
     ASTNode::DataType leftType = node.left->resolvedType;
     ASTNode::DataType rightType = node.right->resolvedType;
 
@@ -95,9 +277,6 @@ void Analyzer::visit(BinaryOpNode& node) {
 
 // *
 void Analyzer::visit(ArrayIndexNode& node) {
-    node.identifier->accept(*this);
-    node.indexExpression->accept(*this);
-
     Symbol *symbol = m_symbolTable.lookupSymbol(node.identifier->name);
     if (symbol == nullptr || !symbol->isArray) {
         error("attempt to index not an array", &node);
@@ -108,9 +287,6 @@ void Analyzer::visit(ArrayIndexNode& node) {
 
 // *
 void Analyzer::visit(AssignmentNode& node) {
-    node.left->accept(*this);
-    node.right->accept(*this);
-
     bool isLValue = false;
 
     // Left member of a binary operation must be l-value
@@ -130,33 +306,24 @@ void Analyzer::visit(AssignmentNode& node) {
     }
 }
 
+// Updates are only made by the optimizer, after the analysis
+void Analyzer::visit(UpdateNode& node) {
+    visit(static_cast<AssignmentNode&>(node));
+}
+
 // *
 void Analyzer::visit([[maybe_unused]] EmptyStatementNode& node) {}
 
 // *
-void Analyzer::visit(CompoundStatementNode& node) {
-    m_symbolTable.enterScope();
-
-    for (auto& statement : node.statements) {
-        statement->accept(*this);
-    }
-
+void Analyzer::visit([[maybe_unused]] CompoundStatementNode& node) {
     m_symbolTable.leaveScope();
 }
 
 // *
 void Analyzer::visit(ForNode& node) {
-    m_symbolTable.enterScope();
-
-    if (node.init) node.init->accept(*this);
-    if (node.condition) {
-        node.condition->accept(*this);
-        if (!isIntegerType(node.condition->resolvedType)) {
-            error("the loop condition must be resolvable to a boolean (integer) value", node.condition.get());
-        }
+    if (node.condition && !isIntegerType(node.condition->resolvedType)) {
+        error("the loop condition must be resolvable to a boolean (integer) value", node.condition.get());
     }
-    if (node.increment) node.increment->accept(*this);
-    if (node.body) node.body->accept(*this);
 
     m_symbolTable.leaveScope();
 }
@@ -164,15 +331,6 @@ void Analyzer::visit(ForNode& node) {
 // *
 void Analyzer::visit(VariableDeclNode& node) {
     std::string name = node.identifier->name;
-
-    if (!m_symbolTable.isUniqueInCurrentScope(name)) {
-        error("redeclaration of '" + name + "'", &node);
-    }
-
-    if (Symbol* symbol = m_symbolTable.lookupSymbol(name)) {
-        if (symbol->isTypedef) error("typename '" + name + "' was used as a variable name", &node);
-    }
-
     ASTNode::DataType finalType = node.type;
     Symbol newSymbol;
 
@@ -195,10 +353,6 @@ void Analyzer::visit(VariableDeclNode& node) {
         newSymbol.isArray = false;
     }
 
-    if (node.initExpression) {
-        node.initExpression->accept(*this);
-    }
-
     newSymbol.type = finalType;
     newSymbol.isTypedef = false;
     newSymbol.declarationNode = &node;
@@ -210,15 +364,6 @@ void Analyzer::visit(VariableDeclNode& node) {
 // *
 void Analyzer::visit(ArrayDeclNode& node) {
     std::string name = node.identifier->name;
-
-    if (!m_symbolTable.isUniqueInCurrentScope(name)) {
-        error("redeclaration of '" + name + "'", &node);
-    }
-
-    if (Symbol* symbol = m_symbolTable.lookupSymbol(name)) {
-        if (symbol->isTypedef) error("typename '" + name + "' was used as a variable name", &node);
-    }
-
     Symbol newSymbol;
     newSymbol.isArray = true;
     newSymbol.declarationNode = &node;
@@ -243,8 +388,6 @@ void Analyzer::visit(ArrayDeclNode& node) {
 
     // Array's size is explicitly specified
     if (node.sizeExpression) {
-        node.sizeExpression->accept(*this);
-
         calculatedSize = evaluateConstantExpression(node.sizeExpression.get());
         if (calculatedSize <= 0) {
             error("the array size must be greater that 0", &node);
@@ -280,10 +423,6 @@ void Analyzer::visit(ArrayDeclNode& node) {
                 node.braceListInit[0].get()
             );
         }
-
-        for (auto& expression : node.braceListInit) {
-            expression->accept(*this);
-        }
     }
 
     if (calculatedSize == -1) {
@@ -295,10 +434,39 @@ void Analyzer::visit(ArrayDeclNode& node) {
     newSymbol.type = node.baseType;
     newSymbol.arraySize = calculatedSize;
 
+    if (node.stringLiteralInit || !node.braceListInit.empty()) {
+        node.initializerImage = buildInitializerImage(node, static_cast<size_t>(calculatedSize));
+    }
+
     m_symbolTable.declare(name, std::move(newSymbol));
     node.identifier->symbolPtr = m_symbolTable.lookupSymbol(name);
 }
 
+// Constant elements are converted to the type of the array once, here
+InitializerImage Analyzer::buildInitializerImage(ArrayDeclNode& node, size_t size) const {
+    InitializerImage image;
+    image.zero = typedValue(node.baseType, 0);
+
+    if (node.stringLiteralInit) {
+        const std::string& text = node.stringLiteralInit->value;
+        image.values.assign(text.begin(), text.end());
+    } else {
+        for (size_t i = 0; i < node.braceListInit.size(); ++i) {
+            int64_t value = 0;
+
+            if (constantValue(node.braceListInit[i].get(), value)) {
+                image.values.push_back(typedValue(node.baseType, value));
+            } else {
+                image.values.push_back(image.zero);
+                image.patches.push_back(i);
+            }
+        }
+    }
+
+    image.zeroTail = size - image.values.size();
+    return image;
+}
+
 // *
 void Analyzer::visit(TypedefNode& node) {
     std::string name = node.newTypeName->name;
@@ -346,29 +514,11 @@ void Analyzer::visit(TypedefNode& node) {
     m_symbolTable.declare(name, std::move(newSymbol));
 }
 
-// *
-void Analyzer::visit(MainDeclNode& node) {
-    if (m_symbolTable.lookupSymbol("main") != nullptr) {
-        error("main function is already declared", &node);
-    }
-
-    Symbol newSymbol;
-    newSymbol.isArray = false;
-    newSymbol.isTypedef = false;
-    newSymbol.declarationNode = &node;
-    newSymbol.type = ASTNode::DataType::INT;
-
-    m_symbolTable.declare("main", std::move(newSymbol));
-
-    node.body->accept(*this);
-}
+// * The symbol is declared on entry, before the body is analyzed
+void Analyzer::visit([[maybe_unused]] MainDeclNode& node) {}
 
 // *
-void Analyzer::visit(ProgramNode& node) {
-    for (auto& decl : node.declarations) {
-        decl->accept(*this);
-    }
-}
+void Analyzer::visit([[maybe_unused]] ProgramNode& node) {}
 
 int32_t Analyzer::evaluateConstantExpression(ExpressionNode* node) {
     if (ConstantNode* constNode = dynamic_cast<ConstantNode*>(node)) {
@@ -441,6 +591,11 @@ void Analyzer::symbDebug(const std::string& name, Symbol* symbol) {
 }
 
 void Analyzer::error(const std::string& error, ASTNode* node) const {
+    // Parallel analysis reports the diagnostics of all blocks together, in source order
+    if (m_isCollectingDiagnostics) {
+        throw Diagnostic{node->m_line, node->m_column, error};
+    }
+
     std::cerr << std::format(
         "{}:{}:{}: semantic error: {}\n", m_filePath, node->m_line, node->m_column, error
     );
@@ -0,0 +1,187 @@
+#include "arithmetic.hpp"
+
+#include <bit>
+#include <cstring>
+#include <string>
+
+__extension__ using Int128 = __int128;
+
+int64_t narrowToType(ASTNode::DataType type, int64_t value) {
+    switch (type) {
+        case ASTNode::DataType::CHAR:  return static_cast<char>(value);
+        case ASTNode::DataType::SHORT: return static_cast<short>(value);
+        case ASTNode::DataType::INT:   return static_cast<int>(value);
+        default:                       return value;
+    }
+}
+
+ValueVariant typedValue(ASTNode::DataType type, int64_t value) {
+    switch (type) {
+        case ASTNode::DataType::CHAR:  return static_cast<char>(value);
+        case ASTNode::DataType::SHORT: return static_cast<short>(value);
+        case ASTNode::DataType::INT:   return static_cast<int>(value);
+        case ASTNode::DataType::LONG:  return static_cast<long>(value);
+        default:                       return std::monostate{};
+    }
+}
+
+size_t typeSize(ASTNode::DataType type) {
+    switch (type) {
+        case ASTNode::DataType::CHAR:  return sizeof(int8_t);
+        case ASTNode::DataType::SHORT: return sizeof(int16_t);
+        case ASTNode::DataType::INT:   return sizeof(int32_t);
+        default:                       return sizeof(int64_t);
+    }
+}
+
+void packValue(ASTNode::DataType type, int64_t value, unsigned char* bytes) {
+    switch (type) {
+        case ASTNode::DataType::CHAR:  { int8_t v = static_cast<int8_t>(value); std::memcpy(bytes, &v, sizeof(v)); break; }
+        case ASTNode::DataType::SHORT: { int16_t v = static_cast<int16_t>(value); std::memcpy(bytes, &v, sizeof(v)); break; }
+        case ASTNode::DataType::INT:   { int32_t v = static_cast<int32_t>(value); std::memcpy(bytes, &v, sizeof(v)); break; }
+        default:                       std::memcpy(bytes, &value, sizeof(value)); break;
+    }
+}
+
+int64_t unpackValue(ASTNode::DataType type, const unsigned char* bytes) {
+    switch (type) {
+        case ASTNode::DataType::CHAR:  { int8_t v; std::memcpy(&v, bytes, sizeof(v)); return v; }
+        case ASTNode::DataType::SHORT: { int16_t v; std::memcpy(&v, bytes, sizeof(v)); return v; }
+        case ASTNode::DataType::INT:   { int32_t v; std::memcpy(&v, bytes, sizeof(v)); return v; }
+        default:                       { int64_t v; std::memcpy(&v, bytes, sizeof(v)); return v; }
+    }
+}
+
+bool evaluateOperator(ASTNode::OperatorType op, int64_t lhs, int64_t rhs, ASTNode::DataType resultType, int64_t& result) {
+    uint64_t l = static_cast<uint64_t>(lhs);
+    uint64_t r = static_cast<uint64_t>(rhs);
+
+    switch (op) {
+        case ASTNode::OperatorType::ADD:  result = static_cast<int64_t>(l + r); break;
+        case ASTNode::OperatorType::SUB:  result = static_cast<int64_t>(l - r); break;
+        case ASTNode::OperatorType::MULT: result = static_cast<int64_t>(l * r); break;
+        case ASTNode::OperatorType::DIV:
+        case ASTNode::OperatorType::MOD: {
+            if (rhs == 0) return false;
+
+            // INT64_MIN / -1 wraps around as well
+            if (rhs == -1) {
+                result = op == ASTNode::OperatorType::DIV ? static_cast<int64_t>(0 - l) : 0;
+            } else {
+                result = op == ASTNode::OperatorType::DIV ? lhs / rhs : lhs % rhs;
+            }
+            break;
+        }
+
+        case ASTNode::OperatorType::BLS:
+        case ASTNode::OperatorType::BRS: {
+            if (rhs < 0 || rhs > 63) return false;
+            result = op == ASTNode::OperatorType::BLS ? static_cast<int64_t>(l << rhs) : lhs >> rhs;
+            break;
+        }
+
+        case ASTNode::OperatorType::EQ:  result = (lhs == rhs) ? 1 : 0; break;
+        case ASTNode::OperatorType::NEQ: result = (lhs != rhs) ? 1 : 0; break;
+        case ASTNode::OperatorType::LT:  result = (lhs < rhs) ? 1 : 0; break;
+        case ASTNode::OperatorType::LE:  result = (lhs <= rhs) ? 1 : 0; break;
+        case ASTNode::OperatorType::GT:  result = (lhs > rhs) ? 1 : 0; break;
+        case ASTNode::OperatorType::GE:  result = (lhs >= rhs) ? 1 : 0; break;
+    }
+
+    result = narrowToType(resultType, result);
+    return true;
+}
+
+// Signed magic numbers, Hacker's Delight 10-1, for 64-bit words
+bool planDivision(int64_t divisor, DivisionPlan& plan) {
+    if (divisor == 0 || divisor == 1 || divisor == -1 || divisor == INT64_MIN) return false;
+
+    uint64_t absolute = divisor < 0 ? 0 - static_cast<uint64_t>(divisor) : static_cast<uint64_t>(divisor);
+
+    plan.divisor = divisor;
+    plan.magic = 0;
+    plan.isPowerOfTwo = std::has_single_bit(absolute);
+
+    if (plan.isPowerOfTwo) {
+        plan.shift = std::countr_zero(absolute);
+        return true;
+    }
+
+    const uint64_t two63 = 1ULL << 63;
+    uint64_t t = two63 + (static_cast<uint64_t>(divisor) >> 63);
+    uint64_t anc = t - 1 - t % absolute; // |nc|
+    int p = 63;
+    uint64_t q1 = two63 / anc, r1 = two63 - q1 * anc;
+    uint64_t q2 = two63 / absolute, r2 = two63 - q2 * absolute;
+    uint64_t delta;
+
+    do {
+        ++p;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) { ++q1; r1 -= anc; }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= absolute) { ++q2; r2 -= absolute; }
+        delta = absolute - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    uint64_t magic = q2 + 1;
+    plan.magic = static_cast<int64_t>(divisor < 0 ? 0 - magic : magic);
+    plan.shift = p - 64;
+    return true;
+}
+
+int64_t divideByPlan(const DivisionPlan& plan, int64_t dividend) {
+    uint64_t n = static_cast<uint64_t>(dividend);
+
+    if (plan.isPowerOfTwo) {
+        // Negative dividends are biased so that the shift rounds towards zero
+        uint64_t bias = static_cast<uint64_t>(dividend >> 63) >> (64 - plan.shift);
+        int64_t quotient = static_cast<int64_t>(n + bias) >> plan.shift;
+        return plan.divisor < 0 ? static_cast<int64_t>(0 - static_cast<uint64_t>(quotient)) : quotient;
+    }
+
+    uint64_t q = static_cast<uint64_t>(static_cast<int64_t>((static_cast<Int128>(plan.magic) * dividend) >> 64));
+    if (plan.divisor > 0 && plan.magic < 0) q += n;
+    if (plan.divisor < 0 && plan.magic > 0) q -= n;
+
+    int64_t quotient = static_cast<int64_t>(q) >> plan.shift;
+    return quotient + static_cast<int64_t>(static_cast<uint64_t>(quotient) >> 63);
+}
+
+int64_t remainderByPlan(const DivisionPlan& plan, int64_t dividend) {
+    uint64_t n = static_cast<uint64_t>(dividend);
+
+    if (plan.isPowerOfTwo) {
+        // Mask the biased dividend, then remove the bias again
+        uint64_t mask = (1ULL << plan.shift) - 1;
+        uint64_t bias = static_cast<uint64_t>(dividend >> 63) & mask;
+        return static_cast<int64_t>(((n + bias) & mask) - bias);
+    }
+
+    uint64_t product = static_cast<uint64_t>(divideByPlan(plan, dividend)) * static_cast<uint64_t>(plan.divisor);
+    return static_cast<int64_t>(n - product);
+}
+
+bool constantValue(const ExpressionNode* node, int64_t& value) {
+    auto constant = dynamic_cast<const ConstantNode*>(node);
+    if (constant == nullptr) return false;
+
+    switch (constant->type) {
+        case ASTNode::ConstantType::INT_10:
+            value = std::stoll(constant->value);
+            break;
+        case ASTNode::ConstantType::INT_16:
+            value = std::stoll(constant->value, nullptr, 16);
+            break;
+        case ASTNode::ConstantType::CHAR_LITERAL:
+            value = static_cast<char>(constant->value[0]);
+            break;
+        case ASTNode::ConstantType::STRING_LITERAL:
+            return false;
+    }
+
+    value = narrowToType(constant->resolvedType, value);
+    return true;
+}
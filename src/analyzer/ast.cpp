@@ -11,6 +11,10 @@ StatementNode::StatementNode(size_t line, size_t column) : ASTNode(line, column)
 
 DeclarationNode::DeclarationNode(size_t line, size_t column) : StatementNode(line, column) {}
 
+ASTNode* ASTNode::child([[maybe_unused]] size_t index) {
+    return nullptr;
+}
+
 IdentifierNode::IdentifierNode(size_t line, size_t column, const std::string& name) :
     ExpressionNode(line, column), name(name)
 {}
@@ -94,6 +98,14 @@ std::string BinaryOpNode::toString() const {
     return "BinaryOp(" + operatorToString(op) + ")";
 }
 
+ASTNode* BinaryOpNode::child(size_t index) {
+    switch (index) {
+        case 0: return left.get();
+        case 1: return right.get();
+        default: return nullptr;
+    }
+}
+
 ArrayIndexNode::ArrayIndexNode(size_t line, size_t column) : ExpressionNode(line, column) {}
 
 void ArrayIndexNode::accept(Visitor& visitor) {
@@ -104,6 +116,14 @@ std::string ArrayIndexNode::toString() const {
     return "ArrayIndex";
 }
 
+ASTNode* ArrayIndexNode::child(size_t index) {
+    switch (index) {
+        case 0: return identifier.get();
+        case 1: return indexExpression.get();
+        default: return nullptr;
+    }
+}
+
 AssignmentNode::AssignmentNode(size_t line, size_t column) : StatementNode(line, column) {}
 
 void AssignmentNode::accept(Visitor& visitor) {
@@ -114,6 +134,24 @@ std::string AssignmentNode::toString() const {
     return "Assignment(=)";
 }
 
+ASTNode* AssignmentNode::child(size_t index) {
+    switch (index) {
+        case 0: return left.get();
+        case 1: return right.get();
+        default: return nullptr;
+    }
+}
+
+UpdateNode::UpdateNode(size_t line, size_t column) : AssignmentNode(line, column) {}
+
+void UpdateNode::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+std::string UpdateNode::toString() const {
+    return "Update(" + operatorToString(static_cast<const BinaryOpNode&>(*right).op) + "=)";
+}
+
 EmptyStatementNode::EmptyStatementNode(size_t line, size_t column) : StatementNode(line, column) {}
 
 void EmptyStatementNode::accept(Visitor& visitor) {
@@ -134,6 +172,10 @@ std::string CompoundStatementNode::toString() const {
     return "CompoundStatement";
 }
 
+ASTNode* CompoundStatementNode::child(size_t index) {
+    return index < statements.size() ? statements[index].get() : nullptr;
+}
+
 ForNode::ForNode(size_t line, size_t column) : StatementNode(line, column) {}
 
 void ForNode::accept(Visitor& visitor) {
@@ -144,6 +186,17 @@ std::string ForNode::toString() const {
     return "ForNode";
 }
 
+ASTNode* ForNode::child(size_t index) {
+    // Every part of the loop header is optional
+    ASTNode* parts[] = {init.get(), condition.get(), increment.get(), body.get()};
+
+    for (ASTNode* part : parts) {
+        if (part && index-- == 0) return part;
+    }
+
+    return nullptr;
+}
+
 VariableDeclNode::VariableDeclNode(size_t line, size_t column) : DeclarationNode(line, column) {}
 
 void VariableDeclNode::accept(Visitor& visitor) {
@@ -154,6 +207,10 @@ std::string VariableDeclNode::toString() const {
     return "VariableDecl(" + typeToString(type) + ")";
 }
 
+ASTNode* VariableDeclNode::child(size_t index) {
+    return index == 0 ? initExpression.get() : nullptr;
+}
+
 ArrayDeclNode::ArrayDeclNode(size_t line, size_t column) : DeclarationNode(line, column) {}
 
 void ArrayDeclNode::accept(Visitor& visitor) {
@@ -164,6 +221,15 @@ std::string ArrayDeclNode::toString() const {
     return "ArrayDecl(" + typeToString(baseType) + ")";
 }
 
+ASTNode* ArrayDeclNode::child(size_t index) {
+    if (sizeExpression) {
+        if (index == 0) return sizeExpression.get();
+        --index;
+    }
+
+    return index < braceListInit.size() ? braceListInit[index].get() : nullptr;
+}
+
 TypedefNode::TypedefNode(size_t line, size_t column) : DeclarationNode(line, column) {}
 
 void TypedefNode::accept(Visitor& visitor) {
@@ -185,6 +251,10 @@ std::string MainDeclNode::toString() const {
     return "MainFunction";
 }
 
+ASTNode* MainDeclNode::child(size_t index) {
+    return index == 0 ? body.get() : nullptr;
+}
+
 ProgramNode::ProgramNode() : ASTNode(0, 0) {}
 
 void ProgramNode::accept(Visitor& visitor) {
@@ -194,3 +264,7 @@ void ProgramNode::accept(Visitor& visitor) {
 std::string ProgramNode::toString() const {
     return "ProgramRoot";
 }
+
+ASTNode* ProgramNode::child(size_t index) {
+    return index < declarations.size() ? declarations[index].get() : nullptr;
+}
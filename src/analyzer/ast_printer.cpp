@@ -1,4 +1,5 @@
 #include "ast_printer.hpp"
+#include "symbol_table.hpp"
 
 #include <iostream>
 
@@ -15,7 +16,17 @@ void ASTPrinter::indent() { m_indentationLevel++; }
 void ASTPrinter::unindent() { m_indentationLevel--; }
 
 void ASTPrinter::print(ASTNode& root) {
-    root.accept(*this);
+    traverse(root);
+}
+
+bool ASTPrinter::preVisit(ASTNode& node) {
+    m_isDescending = false;
+    node.accept(*this);
+    return m_isDescending;
+}
+
+void ASTPrinter::postVisit([[maybe_unused]] ASTNode& node) {
+    unindent();
 }
 
 void ASTPrinter::visit(IdentifierNode& node) {
@@ -26,37 +37,28 @@ void ASTPrinter::visit(ConstantNode& node) {
     printNode(node.toString());
 }
 
-void ASTPrinter::visit([[maybe_unused]]BinaryOpNode& node) {
-    return;
-    // printNode(node.toString());
-    // indent();
-    
-    // node.left->accept(*this);
-    // node.right->accept(*this);
-
-    // unindent();
+void ASTPrinter::visit(BinaryOpNode& node) {
+    printNode(node.toString());
+    indent();
+    m_isDescending = true;
 }
 
-void ASTPrinter::visit([[maybe_unused]]ArrayIndexNode& node) {
-    return;
-    // printNode(node.toString());
-    // indent();
-
-    // node.identifier->accept(*this);
-    // node.indexExpression->accept(*this);
-
-    // unindent();
+void ASTPrinter::visit(ArrayIndexNode& node) {
+    printNode(node.toString());
+    indent();
+    m_isDescending = true;
 }
 
-void ASTPrinter::visit([[maybe_unused]]AssignmentNode& node) {
-    return;    
-    // printNode(node.toString());
-    // indent();
+void ASTPrinter::visit(AssignmentNode& node) {
+    printNode(node.toString());
+    indent();
+    m_isDescending = true;
+}
 
-    // node.left->accept(*this);
-    // node.right->accept(*this);
-    
-    // unindent();
+void ASTPrinter::visit(UpdateNode& node) {
+    printNode(node.toString());
+    indent();
+    m_isDescending = true;
 }
 
 void ASTPrinter::visit([[maybe_unused]]EmptyStatementNode& node) {
@@ -66,30 +68,24 @@ void ASTPrinter::visit([[maybe_unused]]EmptyStatementNode& node) {
 void ASTPrinter::visit(CompoundStatementNode& node) {
     printNode(node.toString());
     indent();
-
-    for (auto& statement : node.statements) {
-        statement->accept(*this);
-    }
-
-    unindent();
+    m_isDescending = true;
 }
 
 void ASTPrinter::visit(ForNode& node) {
     printNode(node.toString());
     indent();
-
-    if (node.init) node.init->accept(*this);
-    if (node.condition) node.condition->accept(*this);
-    if (node.increment) node.increment->accept(*this);
-
-    node.body->accept(*this);
-
-    unindent();
+    m_isDescending = true;
 }
 
 void ASTPrinter::visit(VariableDeclNode& node) {
     std::string s = node.identifier->toString() + "; type: " + ASTNode::typeToString(node.type);
     printNode(s);
+
+    // The initializer is the only child
+    if (node.initExpression) {
+        indent();
+        m_isDescending = true;
+    }
 }
 
 void ASTPrinter::visit(ArrayDeclNode& node) {
@@ -101,6 +97,12 @@ void ASTPrinter::visit(ArrayDeclNode& node) {
         s += ASTNode::typeToString(node.baseType) + "[]";
     }
 
+    // Runtime representation chosen by the optimizer
+    Symbol *symbol = node.identifier->symbolPtr;
+    if (symbol && symbol->details().storageType != ASTNode::DataType::UNKNOWN) {
+        s += "; stored as: " + ASTNode::typeToString(symbol->details().storageType) + "[]";
+    }
+
     printNode(s);
 }
 
@@ -111,19 +113,11 @@ void ASTPrinter::visit(TypedefNode& node) {
 void ASTPrinter::visit(MainDeclNode& node) {
     printNode(node.toString());
     indent();
-
-    node.body->accept(*this);
-
-    unindent();
+    m_isDescending = true;
 }
 
 void ASTPrinter::visit(ProgramNode& node) {
     printNode(node.toString());
     indent();
-
-    for (auto& decl : node.declarations) {
-        decl->accept(*this);
-    }
-
-    unindent();
+    m_isDescending = true;
 }
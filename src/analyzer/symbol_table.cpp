@@ -1,52 +1,219 @@
 #include "symbol_table.hpp"
 
-#include <iostream>
+#include <functional>
 
-SymbolTable::SymbolTable() : 
-    isMainDeclared(false) 
+SymbolTable::SymbolTable() :
+    m_buckets(INITIAL_BUCKETS, 0)
 {
     enterScope(); // Create the global scope
 }
 
+SymbolTable::SymbolTable(std::shared_ptr<const ScopeSnapshot> outerScope) :
+    SymbolTable()
+{
+    m_outerScope = std::move(outerScope);
+}
+
 SymbolTable::~SymbolTable() {
     leaveScope(); // Exit the global scope
 }
 
 void SymbolTable::enterScope() {
-    m_scopeStack.emplace_back();
+    m_scopeMarks.push_back(m_bindings.size());
 }
 
 void SymbolTable::leaveScope() {
-    // To prevent exiting from a global scope    
-    if (m_scopeStack.size() > 1) {
-        m_scopeStack.pop_back();
+    // To prevent exiting from a global scope
+    if (m_scopeMarks.size() <= 1) {
+        return;
+    }
+
+    size_t mark = m_scopeMarks.back();
+    m_scopeMarks.pop_back();
+
+    if (m_bindings.size() > mark) {
+        m_snapshot.reset();
+    }
+
+    // Unwind the bindings of the scope, making the shadowed ones visible again
+    while (m_bindings.size() > mark) {
+        const Binding& binding = m_bindings.back();
+        m_names[binding.nameId].innermost = binding.shadowed;
+        m_bindings.pop_back();
     }
 }
 
 bool SymbolTable::declare(const std::string& name, Symbol&& symbol) {
-    if (m_scopeStack.empty()) return false;
+    if (m_scopeMarks.empty()) return false;
 
-    m_scopeStack.back().insert(std::make_pair(name, symbol));
+    uint32_t id = internName(name);
+    int32_t& innermost = m_names[id].innermost;
+
+    // Keep the first declaration if the name is already bound in this scope
+    if (innermost != NO_BINDING && m_bindings[innermost].depth == currentDepth()) {
+        return true;
+    }
+
+    m_snapshot.reset();
+
+    uint32_t symbolId = m_arena.allocate(std::move(symbol));
+    m_bindings.push_back(Binding{id, currentDepth(), innermost, symbolId});
+    innermost = static_cast<int32_t>(m_bindings.size() - 1);
     return true;
 }
 
 bool SymbolTable::isUniqueInCurrentScope(const std::string& name) const {
-    if (m_scopeStack.empty()) return false;
+    if (m_scopeMarks.empty()) return false;
+
+    uint32_t id = findName(name);
+    if (id == NO_NAME) return true;
 
-    const auto& scope = m_scopeStack.back();
-    return scope.find(name) == scope.end();
+    int32_t innermost = m_names[id].innermost;
+    return innermost == NO_BINDING || m_bindings[innermost].depth != currentDepth();
 }
 
 Symbol* SymbolTable::lookupSymbol(const std::string& name) {
-    if (m_scopeStack.empty()) return nullptr;
+    uint32_t id = findName(name);
 
-    for (auto it = m_scopeStack.rbegin(); it != m_scopeStack.rend(); ++it) {
-        auto found = it->find(name);
+    if (id != NO_NAME && m_names[id].innermost != NO_BINDING) {
+        return &m_arena[m_bindings[m_names[id].innermost].symbolId];
+    }
 
-        if (found != it->end()) {
-            return &found->second;
-        }
+    if (m_outerScope) {
+        auto found = m_outerScope->find(name);
+        if (found != m_outerScope->end()) return found->second;
     }
 
     return nullptr;
-}
\ No newline at end of file
+}
+
+std::shared_ptr<const ScopeSnapshot> SymbolTable::snapshot() {
+    if (m_snapshot) return m_snapshot;
+
+    auto view = std::make_shared<ScopeSnapshot>();
+    if (m_outerScope) *view = *m_outerScope;
+
+    for (const Name& name : m_names) {
+        if (name.innermost != NO_BINDING) {
+            (*view)[name.spelling] = &m_arena[m_bindings[name.innermost].symbolId];
+        }
+    }
+
+    m_snapshot = std::move(view);
+    return m_snapshot;
+}
+
+void SymbolTable::adopt(SymbolTable&& other) {
+    m_arena.adopt(std::move(other.m_arena));
+}
+
+Symbol* SymbolTable::createAnonymous(Symbol&& symbol) {
+    return &m_arena[m_arena.allocate(std::move(symbol))];
+}
+
+Symbol* SymbolTable::createTemporary(Symbol&& symbol) {
+    symbol.isCompilerTemporary = true;
+    ++m_temporaryCount;
+    return createAnonymous(std::move(symbol));
+}
+
+size_t SymbolTable::temporaryCount() const {
+    return m_temporaryCount;
+}
+
+uint32_t SymbolTable::findName(const std::string& name) const {
+    size_t hash = std::hash<std::string>{}(name);
+    size_t mask = m_buckets.size() - 1;
+
+    for (size_t i = hash & mask; m_buckets[i] != 0; i = (i + 1) & mask) {
+        const Name& candidate = m_names[m_buckets[i] - 1];
+
+        if (candidate.hash == hash && candidate.spelling == name) {
+            return m_buckets[i] - 1;
+        }
+    }
+
+    return NO_NAME;
+}
+
+uint32_t SymbolTable::internName(const std::string& name) {
+    uint32_t id = findName(name);
+    if (id != NO_NAME) return id;
+
+    // Keep the load factor under 1/2 so that probe sequences stay short
+    if ((m_names.size() + 1) * 2 > m_buckets.size()) {
+        rehash(m_buckets.size() * 2);
+    }
+
+    size_t hash = std::hash<std::string>{}(name);
+    size_t mask = m_buckets.size() - 1;
+    size_t i = hash & mask;
+
+    while (m_buckets[i] != 0) {
+        i = (i + 1) & mask;
+    }
+
+    id = static_cast<uint32_t>(m_names.size());
+    m_names.push_back(Name{name, hash});
+    m_buckets[i] = id + 1;
+
+    return id;
+}
+
+void SymbolTable::rehash(size_t bucketCount) {
+    m_buckets.assign(bucketCount, 0);
+    size_t mask = bucketCount - 1;
+
+    for (uint32_t id = 0; id < m_names.size(); ++id) {
+        size_t i = m_names[id].hash & mask;
+
+        while (m_buckets[i] != 0) {
+            i = (i + 1) & mask;
+        }
+
+        m_buckets[i] = id + 1;
+    }
+}
+
+uint32_t SymbolTable::currentDepth() const {
+    return static_cast<uint32_t>(m_scopeMarks.size() - 1);
+}
+
+const SymbolDetails SymbolDetails::NONE;
+
+SymbolDetails& Symbol::editDetails() {
+    if (!m_details) m_details = std::make_unique<SymbolDetails>();
+    return *m_details;
+}
+
+uint32_t SymbolArena::allocate(Symbol&& symbol) {
+    if (m_size == m_chunks.size() * CHUNK_SIZE) {
+        m_chunks.push_back(std::make_unique<Symbol[]>(CHUNK_SIZE));
+    }
+
+    uint32_t index = static_cast<uint32_t>(m_size++);
+    (*this)[index] = std::move(symbol);
+    return index;
+}
+
+Symbol& SymbolArena::operator[](uint32_t index) {
+    return m_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+}
+
+const Symbol& SymbolArena::operator[](uint32_t index) const {
+    return m_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+}
+
+void SymbolArena::adopt(SymbolArena&& other) {
+    for (auto& chunk : other.m_chunks) {
+        m_adoptedChunks.push_back(std::move(chunk));
+    }
+
+    for (auto& chunk : other.m_adoptedChunks) {
+        m_adoptedChunks.push_back(std::move(chunk));
+    }
+
+    other.m_chunks.clear();
+    other.m_adoptedChunks.clear();
+    other.m_size = 0;
+}
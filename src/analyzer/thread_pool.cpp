@@ -0,0 +1,110 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) threadCount = 1;
+
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<TaskQueue>());
+    }
+
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_isStopping = true;
+    }
+
+    m_taskAvailable.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index;
+
+    // Count the task before it becomes visible so that the counter never underflows
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        ++m_queued;
+        ++m_unfinished;
+        index = m_nextQueue;
+        m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(std::move(task));
+    }
+
+    m_taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(m_stateMutex);
+    m_allDone.wait(lock, [this] { return m_unfinished == 0; });
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    while (true) {
+        std::function<void()> task;
+
+        if (takeTask(index, task)) {
+            task();
+
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            if (--m_unfinished == 0) {
+                m_allDone.notify_all();
+            }
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_stateMutex);
+        m_taskAvailable.wait(lock, [this] { return m_isStopping || m_queued > 0; });
+
+        if (m_isStopping && m_queued == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::takeTask(size_t index, std::function<void()>& task) {
+    bool isTaken = false;
+
+    // Own queue first, newest task
+    {
+        TaskQueue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            isTaken = true;
+        }
+    }
+
+    // Steal the oldest task of another worker
+    for (size_t i = 1; !isTaken && i < m_queues.size(); ++i) {
+        TaskQueue& victim = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            isTaken = true;
+        }
+    }
+
+    if (isTaken) {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        --m_queued;
+    }
+
+    return isTaken;
+}
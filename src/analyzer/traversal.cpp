@@ -0,0 +1,44 @@
+#include "traversal.hpp"
+
+namespace {
+
+thread_local size_t visitedNodes = 0;
+
+} // namespace
+
+size_t Traversal::visitedCount() {
+    return visitedNodes;
+}
+
+void Traversal::traverse(ASTNode& root) {
+    // Frames below the base belong to a traversal which is still in progress
+    size_t base = m_stack.size();
+
+    ++visitedNodes;
+    if (!preVisit(root)) return;
+    m_stack.push_back(Frame{&root, 0});
+
+    while (m_stack.size() > base) {
+        Frame& frame = m_stack.back();
+        ASTNode* child = nextChild(*frame.node, frame.step);
+
+        if (child == nullptr) {
+            ASTNode* node = frame.node;
+            m_stack.pop_back();
+            postVisit(*node);
+        } else {
+            ++visitedNodes;
+            if (preVisit(*child)) m_stack.push_back(Frame{child, 0});
+        }
+    }
+}
+
+bool Traversal::preVisit([[maybe_unused]] ASTNode& node) {
+    return true;
+}
+
+ASTNode* Traversal::nextChild(ASTNode& node, size_t& step) {
+    return node.child(step++);
+}
+
+void Traversal::postVisit([[maybe_unused]] ASTNode& node) {}
@@ -1,33 +1,141 @@
 #include "interpreter.hpp"
 #include "analyzer.hpp"
+#include "arithmetic.hpp"
 
-Interpreter::Interpreter(const std::string& filepath, SymbolTable& symbolTable) : 
+#include <algorithm>
+#include <cstring>
+
+Interpreter::Interpreter(const std::string& filepath, SymbolTable& symbolTable, std::ostream& out, EvaluationBudget* budget) :
     m_filepath(filepath),
-    m_symbolTable(symbolTable)    
+    m_symbolTable(symbolTable),
+    m_out(out),
+    m_budget(budget)
 {}
 
 void Interpreter::interprete(ASTNode& root) {
-    root.accept(*this);
+    traverse(root);
 }
 
-void Interpreter::visit(IdentifierNode& node) {
-    if (std::holds_alternative<std::monostate>(node.symbolPtr->value)) {
-        error("Usage of uninitialized variable + " + node.name, &node);
+ASTNode* Interpreter::nextChild(ASTNode& node, size_t& step) {
+    if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        return nextLoopStep(*forNode, step);
+    }
+
+    if (auto update = dynamic_cast<UpdateNode*>(&node)) {
+        return nextUpdateStep(*update, step);
+    }
+
+    // The right side is evaluated first, then the index of an element being assigned
+    if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+        switch (step++) {
+            case 0: return assignment->right.get();
+            case 1: {
+                auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get());
+                return element ? element->indexExpression.get() : nullptr;
+            }
+            default: return nullptr;
+        }
+    }
+
+    // The divisor of a lowered division is folded into its plan
+    if (auto binary = dynamic_cast<BinaryOpNode*>(&node); binary && binary->divisionPlan) {
+        return step++ == 0 ? binary->left.get() : nullptr;
+    }
+
+    // Array names aren't values, only the index is evaluated
+    if (auto element = dynamic_cast<ArrayIndexNode*>(&node)) {
+        return step++ == 0 ? element->indexExpression.get() : nullptr;
+    }
+
+    // The size of an array is already known, only the initializers missing from its image are evaluated
+    if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+        size_t index = step++;
+        if (!arrayDecl->initializerImage || index >= arrayDecl->initializerImage->patches.size()) return nullptr;
+        return arrayDecl->braceListInit[arrayDecl->initializerImage->patches[index]].get();
+    }
+
+    return node.child(step++);
+}
+
+void Interpreter::postVisit(ASTNode& node) {
+    if (m_budget) {
+        if (m_budget->fuel == 0) throw EvaluationStopped{"out of fuel"};
+        --m_budget->fuel;
+    }
+
+    node.accept(*this);
+}
+
+// Steps: 0 - init, 1 - condition, 2 - check the condition and run the body, 3 - increment.
+// Nothing leaves a loop but its condition, so a loop without one is reported once its init ran.
+ASTNode* Interpreter::nextLoopStep(ForNode& node, size_t& step) {
+    while (true) {
+        switch (step) {
+            case 0:
+                step = 1;
+                if (node.init) return node.init.get();
+                break;
+            case 1:
+                step = 2;
+                if (!node.condition) error("the loop has no condition and never terminates", &node);
+                return node.condition.get();
+            case 2:
+                if (getNumericValue(popValue()) == 0) return nullptr;
+                step = 3;
+                return node.body.get();
+            default:
+                step = 1;
+                if (node.increment) return node.increment.get();
+                break;
+        }
+    }
+}
+
+// Steps: 0 - index of the target, 1 - read the target and evaluate the other operand.
+// The read runs where the operation would have evaluated it, so it fails the same way.
+ASTNode* Interpreter::nextUpdateStep(UpdateNode& node, size_t& step) {
+    auto& operation = static_cast<BinaryOpNode&>(*node.right);
+    auto read = dynamic_cast<ArrayIndexNode*>(operation.left.get());
+
+    if (step == 0 && read) {
+        step = 1;
+        return read->indexExpression.get();
+    }
+
+    if (step > 1) return nullptr;
+    step = 2;
+
+    // The index stays on the stack for the store
+    if (read) {
+        m_values.push_back(m_values.back());
+        visit(*read);
+    } else {
+        visit(static_cast<IdentifierNode&>(*operation.left));
     }
 
-    m_lastExpressionValue = std::variant(node.symbolPtr->value);
+    // The divisor of a lowered division is folded into its plan
+    return operation.divisionPlan ? nullptr : operation.right.get();
+}
+
+void Interpreter::visit(IdentifierNode& node) {
+    if (std::holds_alternative<std::monostate>(node.symbolPtr->slot().value)) {
+        // A promoted element is named like the element, "a[2]"
+        if (node.symbolPtr->details().elementOf) {
+            error("usage of uninitialized element of '" + node.name.substr(0, node.name.find('[')) + "'", &node);
+        }
 
-    if (std::holds_alternative<long>(m_lastExpressionValue)) {
-        std::cout << "long\n";
+        error("Usage of uninitialized variable + " + node.name, &node);
     }
+
+    m_values.push_back(node.symbolPtr->slot().value);
 }
 
 void Interpreter::visit(ConstantNode& node) {
-    // The Analyzer already resolved node.resolvedType. 
+    // The Analyzer already resolved node.resolvedType.
     // We strictly use that to ensure the variant holds the correct alternative.
     switch (node.resolvedType) {
         case ASTNode::DataType::CHAR:
-            m_lastExpressionValue = static_cast<char>(node.value[0]);
+            m_values.push_back(static_cast<char>(node.value[0]));
             break;
         case ASTNode::DataType::INT:
         case ASTNode::DataType::SHORT:
@@ -35,141 +143,253 @@ void Interpreter::visit(ConstantNode& node) {
             // Parse based on radix provided in node.type
             if (node.type == ASTNode::ConstantType::INT_16) {
                 long long val = std::stoll(node.value, nullptr, 16);
-                m_lastExpressionValue = createValue(node.resolvedType, val);
+                m_values.push_back(createValue(node.resolvedType, val));
             } else {
                 long long val = std::stoll(node.value);
-                m_lastExpressionValue = createValue(node.resolvedType, val);
+                m_values.push_back(createValue(node.resolvedType, val));
             }
             break;
         default:
-             m_lastExpressionValue = std::monostate{};
+            m_values.push_back(std::monostate{});
     }
 }
 
 void Interpreter::visit(BinaryOpNode& node) {
-    node.left->accept(*this);
-    ValueVariant lhs = m_lastExpressionValue;
-    node.right->accept(*this);
-    ValueVariant rhs = m_lastExpressionValue;
-
-    m_lastExpressionValue = std::visit(
-        [&](auto&& l_val, auto&& r_val) -> ValueVariant {
-            using T1 = std::decay_t<decltype(l_val)>;
-            using T2 = std::decay_t<decltype(r_val)>;
-
-            if constexpr (std::is_same_v<T1, std::monostate> || std::is_same_v<T2, std::monostate>) {
-                error("usage of uninitialzed variable", node.left.get());
-            } else {
-                
-                long long v1 = static_cast<long long>(l_val);
-                long long v2 = static_cast<long long>(r_val);
-
-                switch (node.op) {
-                    case ASTNode::OperatorType::ADD:  return v1 + v2;
-                    case ASTNode::OperatorType::SUB:  return v1 - v2;
-                    case ASTNode::OperatorType::MULT: return v1 * v2;
-                    case ASTNode::OperatorType::DIV:  
-                        if (v2 % 2 == 0) error("division by 0", node.right.get());
-                        return v1 / v2;
-                    case ASTNode::OperatorType::MOD:  
-                        if (v2 % 2 == 0) error("division by 0", node.right.get());
-                        return v1 % v2;
-
-                    case ASTNode::OperatorType::BLS: return v1 << v2;
-                    case ASTNode::OperatorType::BRS: return v1 >> v2;
-                    
-                    case ASTNode::OperatorType::EQ:  return (v1 == v2) ? 1 : 0;
-                    case ASTNode::OperatorType::NEQ: return (v1 != v2) ? 1 : 0;
-                    case ASTNode::OperatorType::LT:  return (v1 < v2) ? 1 : 0;
-                    case ASTNode::OperatorType::LE:  return (v1 <= v2) ? 1 : 0;
-                    case ASTNode::OperatorType::GT:  return (v1 > v2) ? 1 : 0;
-                    case ASTNode::OperatorType::GE:  return (v1 >= v2) ? 1 : 0;
-                }
-            }                
-            return std::monostate{};
-        },
-        lhs, rhs
-    );
+    if (node.divisionPlan) {
+        ValueVariant lhs = popValue();
 
-            
-    ASTNode::DataType resultType = node.resolvedType;
-    std::cout << static_cast<int>(resultType) << std::endl;
-
-    std::visit([resultType](auto& value){
-        if constexpr (!std::is_same_v<std::decay_t<decltype(value)>, std::monostate>) {
-            switch (resultType) {
-                case ASTNode::DataType::INT:   value = static_cast<int>(value); break;
-                case ASTNode::DataType::SHORT: value = static_cast<short>(value); break;
-                case ASTNode::DataType::LONG:  value = static_cast<long>(value); break;
-                case ASTNode::DataType::CHAR:  value = static_cast<char>(value); break;
-                default: break;
-            }
+        if (std::holds_alternative<std::monostate>(lhs)) {
+            error("usage of uninitialzed variable", node.left.get());
         }
-    }, m_lastExpressionValue);
+
+        int64_t v1 = getNumericValue(lhs);
+        int64_t result = node.op == ASTNode::OperatorType::DIV
+            ? divideByPlan(*node.divisionPlan, v1)
+            : remainderByPlan(*node.divisionPlan, v1);
+
+        m_values.push_back(createValue(node.resolvedType, result));
+        return;
+    }
+
+    ValueVariant rhs = popValue();
+    ValueVariant lhs = popValue();
+
+    if (std::holds_alternative<std::monostate>(lhs) || std::holds_alternative<std::monostate>(rhs)) {
+        error("usage of uninitialzed variable", node.left.get());
+    }
+
+    int64_t v1 = getNumericValue(lhs);
+    int64_t v2 = getNumericValue(rhs);
+    int64_t result = 0;
+
+    // The result is narrowed to the type assigned by the Analyzer. The error is reported at the
+    // operation rather than at its right operand, which the optimizer may replace by a part of it.
+    if (!evaluateOperator(node.op, v1, v2, node.resolvedType, result)) {
+        bool isShift = node.op == ASTNode::OperatorType::BLS || node.op == ASTNode::OperatorType::BRS;
+        error(isShift ? "shift amount out of range" : "division by 0", &node);
+    }
+
+    m_values.push_back(createValue(node.resolvedType, result));
 }
 
-void Interpreter::visit([[maybe_unused]]ArrayIndexNode& node) {
-    return;
+void Interpreter::visit(ArrayIndexNode& node) {
+    ValueVariant index = popValue();
+    ValueVariant element = loadElement(node.identifier->symbolPtr, elementPosition(node, index));
+
+    if (std::holds_alternative<std::monostate>(element)) {
+        error("usage of uninitialized element of '" + node.identifier->name + "'", &node);
+    }
+
+    m_values.push_back(element);
 }
 
 void Interpreter::visit(AssignmentNode& node) {
-    node.right->accept(*this);
-    ValueVariant rhs = m_lastExpressionValue;
+    if (auto element = dynamic_cast<ArrayIndexNode*>(node.left.get())) {
+        ValueVariant index = popValue();
+        ValueVariant rhs = popValue();
+        Symbol *symbol = element->identifier->symbolPtr;
+
+        ValueVariant target = storeElement(symbol, elementPosition(*element, index), getNumericValue(rhs));
 
-    if (IdentifierNode *ident = dynamic_cast<IdentifierNode*>(node.left.get())) {
-        ident->symbolPtr->value = rhs;
-        std::cout << "[Assignment]: " << ident->name << " = ";
-        variantPrinter(rhs);
-        std::cout << std::endl;
+        m_out << "[Assignment]: " << element->identifier->name << "[" << getNumericValue(index) << "] = ";
+        variantPrinter(target);
+        m_out << std::endl;
+    } else if (IdentifierNode *ident = dynamic_cast<IdentifierNode*>(node.left.get())) {
+        ValueVariant rhs = popValue();
+        performAssignment(ident->symbolPtr, rhs);
+        if (ident->symbolPtr->isCompilerTemporary) return;
+
+        m_out << "[Assignment]: " << ident->name << " = ";
+        variantPrinter(ident->symbolPtr->slot().value);
+        m_out << std::endl;
     }
 }
 
-void Interpreter::visit([[maybe_unused]]EmptyStatementNode& node) {
-    return;
+// The result narrows to the type of the operation, then to the type of the target as it's stored
+void Interpreter::visit(UpdateNode& node) {
+    visit(static_cast<BinaryOpNode&>(*node.right));
+
+    // An element store takes the index from under the value, as the assignment evaluates it last
+    if (dynamic_cast<ArrayIndexNode*>(node.left.get())) {
+        std::swap(m_values[m_values.size() - 1], m_values[m_values.size() - 2]);
+    }
+
+    visit(static_cast<AssignmentNode&>(node));
 }
 
-void Interpreter::visit(CompoundStatementNode& node) {
-    for (auto& statement : node.statements) {
-        statement->accept(*this);
+void Interpreter::visit(EmptyStatementNode& node) {
+    if (!node.trace.empty()) {
+        m_out << node.trace << std::endl;
     }
 }
 
+void Interpreter::visit([[maybe_unused]]CompoundStatementNode& node) {
+    return;
+}
+
 void Interpreter::visit([[maybe_unused]]ForNode& node) {
     return;
 }
 
 void Interpreter::visit(VariableDeclNode& node) {
+    Symbol *symbol = node.identifier->symbolPtr;
+
+    // A typedef-name can stand for an array type
+    if (symbol->isArray) {
+        initializeArray(symbol, nullptr);
+
+        for (Symbol* element : symbol->details().promotedElements) {
+            element->value = std::monostate{};
+        }
+
+        m_out << "[Declaration]: " << node.identifier->name << "[" << symbol->arraySize << "]" << std::endl;
+        return;
+    }
+
     if (node.initExpression) {
-        node.initExpression->accept(*this);
-        ValueVariant initValue = m_lastExpressionValue;
-        Symbol *symbol = node.identifier->symbolPtr;
-        symbol->value = initValue;
-        std::cout << "[Declaration]: " << node.identifier->name << " = ";
-        variantPrinter(symbol->value);
-        std::cout << std::endl;
+        performAssignment(symbol, popValue());
+        if (symbol->isCompilerTemporary) return;
+
+        m_out << "[Declaration]: " << node.identifier->name << " = ";
+        variantPrinter(symbol->slot().value);
+        m_out << std::endl;
+    } else {
+        // Declarations inside loops start over on every iteration
+        symbol->slot().value = std::monostate{};
     }
 }
 
 void Interpreter::visit(ArrayDeclNode& node) {
     Symbol *symbol = node.identifier->symbolPtr;
-    std::cout << symbol->arraySize << std::endl;
+    initializeArray(symbol, node.initializerImage ? &*node.initializerImage : nullptr);
+
+    // The elements which aren't constant were evaluated in order and are patched over the image
+    if (node.initializerImage) {
+        const std::vector<size_t>& patches = node.initializerImage->patches;
+
+        for (size_t i = patches.size(); i > 0; --i) {
+            storeElement(symbol, patches[i - 1], getNumericValue(popValue()));
+        }
+    }
+
+    for (Symbol* element : symbol->details().promotedElements) {
+        element->value = loadElement(symbol, static_cast<size_t>(element->details().elementIndex));
+    }
+
+    m_out << "[Declaration]: " << node.identifier->name << "[" << symbol->arraySize << "]" << std::endl;
 }
 
 void Interpreter::visit([[maybe_unused]]TypedefNode& node) {
     return;
 }
 
-void Interpreter::visit(MainDeclNode& node) {
-    node.body->accept(*this);
+void Interpreter::visit([[maybe_unused]]MainDeclNode& node) {
+    return;
+}
+
+void Interpreter::visit([[maybe_unused]]ProgramNode& node) {
+    return;
+}
+
+ValueVariant Interpreter::popValue() {
+    ValueVariant value = m_values.back();
+    m_values.pop_back();
+    return value;
+}
+
+size_t Interpreter::elementPosition(ArrayIndexNode& node, const ValueVariant& index) {
+    Symbol *symbol = node.identifier->symbolPtr;
+    int64_t position = getNumericValue(index);
+
+    if (!node.isIndexInBounds && (position < 0 || position >= symbol->arraySize)) {
+        error(
+            "index " + std::to_string(position) + " is out of bounds of the array '" +
+            node.identifier->name + "' of size " + std::to_string(symbol->arraySize),
+            &node
+        );
+    }
+
+    return static_cast<size_t>(position);
+}
+
+// The elements of a narrowed array widen to the type of the array when they're loaded
+ValueVariant Interpreter::loadElement(Symbol* array, size_t position) const {
+    const Symbol& slot = array->slot();
+    ASTNode::DataType storageType = array->details().storageType;
+    if (storageType == ASTNode::DataType::UNKNOWN) return slot.arrayValues[position];
+
+    const SymbolDetails& storage = slot.details();
+    if (!storage.initializedValues[position]) return std::monostate{};
+
+    size_t width = typeSize(storageType);
+    return createValue(array->type, unpackValue(storageType, &storage.packedValues[position * width]));
 }
 
-void Interpreter::visit(ProgramNode& node) {
-    for (auto& declaration : node.declarations) {
-        declaration->accept(*this);
+// Returns the value stored, converted to the type of the array
+ValueVariant Interpreter::storeElement(Symbol* array, size_t position, int64_t value) {
+    Symbol& slot = array->slot();
+    ValueVariant stored = createValue(array->type, value);
+
+    if (array->details().storageType == ASTNode::DataType::UNKNOWN) {
+        slot.arrayValues[position] = stored;
+    } else {
+        size_t width = typeSize(array->details().storageType);
+        SymbolDetails& storage = slot.editDetails();
+        packValue(array->details().storageType, getNumericValue(stored), &storage.packedValues[position * width]);
+        storage.initializedValues[position] = true;
     }
+
+    return stored;
 }
 
+// The image is copied over the storage in place: its packed bytes for a narrowed array, with memcpy and
+// memset, and its values otherwise. An array without one is uninitialized
+void Interpreter::initializeArray(Symbol* array, const InitializerImage* image) {
+    reserveArray(array);
+    Symbol& slot = array->slot();
+    size_t size = static_cast<size_t>(array->arraySize);
+
+    if (array->details().storageType != ASTNode::DataType::UNKNOWN) {
+        SymbolDetails& storage = slot.editDetails();
+
+        if (image) {
+            std::memcpy(storage.packedValues.data(), image->packed.data(), image->packed.size());
+            std::memset(storage.packedValues.data() + image->packed.size(), 0, image->zeroTail * typeSize(array->details().storageType));
+        }
+
+        std::fill_n(storage.initializedValues.begin(), size, image != nullptr);
+    } else if (image) {
+        auto tail = std::copy(image->values.begin(), image->values.end(), slot.arrayValues.begin());
+        std::fill_n(tail, image->zeroTail, image->zero);
+    } else {
+        std::fill_n(slot.arrayValues.begin(), size, std::monostate{});
+    }
+}
+
+// A budgeted run leaves the error to the actual run
 void Interpreter::error(const std::string& error, ASTNode* node) const {
+    if (m_budget) throw EvaluationStopped{"it raises a runtime error"};
+
     std::cerr << std::format(
         "{}:{}:{}: semantic error: {}\n", m_filepath, node->m_line, node->m_column, error
     );
@@ -177,25 +397,49 @@ void Interpreter::error(const std::string& error, ASTNode* node) const {
     exit(EXIT_FAILURE);
 }
 
+// The storage of an array lives as long as its slot. It only grows when a declaration needs more
+// elements than it has; executing the declaration again, as in a loop, only initializes it again
+void Interpreter::reserveArray(Symbol* array) {
+    Symbol& slot = array->slot();
+    size_t size = static_cast<size_t>(array->arraySize);
+    bool isPacked = array->details().storageType != ASTNode::DataType::UNKNOWN;
+    size_t reserved = isPacked ? slot.details().initializedValues.size() : slot.arrayValues.size();
+
+    if (reserved >= size) return;
+    allocate(size - reserved);
+
+    if (isPacked) {
+        slot.editDetails().packedValues.resize(size * typeSize(array->details().storageType));
+        slot.editDetails().initializedValues.resize(size);
+    } else {
+        slot.arrayValues.resize(size);
+    }
+}
+
+void Interpreter::allocate(size_t elements) {
+    if (m_budget == nullptr) return;
+    if (m_budget->memory < elements) throw EvaluationStopped{"out of memory"};
+    m_budget->memory -= elements;
+}
+
 void Interpreter::variantPrinter(const ValueVariant& val) const {
     if (std::holds_alternative<long>(val)) {
-        std::cout << "(long) " << std::get<long>(val);
+        m_out << "(long) " << std::get<long>(val);
     } else if (std::holds_alternative<int>(val)) {
-        std::cout << "(int) " << std::get<int>(val);
+        m_out << "(int) " << std::get<int>(val);
     } else if (std::holds_alternative<short>(val)) {
-        std::cout << "(short) " << std::get<short>(val);
+        m_out << "(short) " << std::get<short>(val);
     }  else if (std::holds_alternative<char>(val)) {
         char ch = std::get<char>(val);
-        std::cout << "(char) " << "'" << ch << "' (ASCII: " << static_cast<int>(ch) << ")";
+        m_out << "(char) " << "'" << ch << "' (ASCII: " << static_cast<int>(ch) << ")";
     } else if (std::holds_alternative<std::monostate>(val)) {
-        std::cout << "?";
+        m_out << "?";
     }
 }
 
+// Store a value converted to the type of the target
 void Interpreter::performAssignment(Symbol* target, const ValueVariant& rhs) {
-    ASTNode::DataType targetType = target->type;
-
-    
+    target->slot().value = createValue(target->type, getNumericValue(rhs));
 }
 
 // Extract a numeric value from the variant as long long
@@ -209,12 +453,11 @@ int64_t Interpreter::getNumericValue(const ValueVariant& val) const {
 
 // Create a variant of the specific AST type from a raw numeric value
 ValueVariant Interpreter::createValue(ASTNode::DataType type, int64_t val) const {
-    switch (type) {
-        case ASTNode::DataType::CHAR:  return static_cast<char>(val);
-        case ASTNode::DataType::SHORT: return static_cast<short>(val);
-        case ASTNode::DataType::INT:   return static_cast<int>(val);
-        case ASTNode::DataType::LONG:  return static_cast<long>(val);
-        default:
-            throw std::runtime_error("Runtime Error: Cannot create value for unknown/custom type.");
+    ValueVariant value = typedValue(type, val);
+
+    if (std::holds_alternative<std::monostate>(value)) {
+        throw std::runtime_error("Runtime Error: Cannot create value for unknown/custom type.");
     }
-}
\ No newline at end of file
+
+    return value;
+}
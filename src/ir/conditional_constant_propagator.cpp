@@ -0,0 +1,197 @@
+#include "conditional_constant_propagator.hpp"
+#include "arithmetic.hpp"
+
+void ConditionalConstantPropagator::run(IRFunction& function) {
+    m_values.clear();
+    m_users.clear();
+    m_executableBlocks.clear();
+    m_executableEdges.clear();
+
+    for (const auto& block : function.blocks()) {
+        for (const auto& instruction : block->instructions) {
+            for (Instruction* operand : instruction->operands) {
+                m_users[operand].push_back(instruction.get());
+            }
+        }
+    }
+
+    propagate(function);
+    rewrite(function);
+}
+
+size_t ConditionalConstantPropagator::constantCount() const {
+    return m_constantCount;
+}
+
+size_t ConditionalConstantPropagator::foldedBranchCount() const {
+    return m_foldedBranchCount;
+}
+
+size_t ConditionalConstantPropagator::removedBlockCount() const {
+    return m_removedBlockCount;
+}
+
+// A block is visited whole the first time one of its edges becomes executable, its
+// phis again for every later edge; a value is visited again whenever an operand changes
+void ConditionalConstantPropagator::propagate(IRFunction& function) {
+    m_executableBlocks.insert(function.entry());
+    for (const auto& instruction : function.entry()->instructions) {
+        visit(*instruction);
+    }
+
+    while (!m_edgeWorklist.empty() || !m_valueWorklist.empty()) {
+        if (!m_edgeWorklist.empty()) {
+            auto [from, to] = m_edgeWorklist.back();
+            m_edgeWorklist.pop_back();
+
+            bool isFirstVisit = m_executableBlocks.insert(to).second;
+
+            for (const auto& instruction : to->instructions) {
+                if (!isFirstVisit && instruction->opcode != Opcode::PHI) break;
+                visit(*instruction);
+            }
+        } else {
+            Instruction *instruction = m_valueWorklist.back();
+            m_valueWorklist.pop_back();
+
+            if (m_executableBlocks.count(instruction->parent)) visit(*instruction);
+        }
+    }
+}
+
+void ConditionalConstantPropagator::visit(Instruction& instruction) {
+    switch (instruction.opcode) {
+        case Opcode::CONST:
+            update(instruction, Lattice{Lattice::CONSTANT, instruction.constant});
+            break;
+        case Opcode::CONVERT: {
+            Lattice operand = valueOf(instruction.operands[0]);
+            if (operand.state == Lattice::CONSTANT) operand.value = narrowToType(instruction.type, operand.value);
+            update(instruction, operand);
+            break;
+        }
+        case Opcode::BINARY: {
+            Lattice lhs = valueOf(instruction.operands[0]);
+            Lattice rhs = valueOf(instruction.operands[1]);
+            Lattice result;
+
+            if (lhs.state == Lattice::OVERDEFINED || rhs.state == Lattice::OVERDEFINED) {
+                result.state = Lattice::OVERDEFINED;
+            } else if (lhs.state == Lattice::CONSTANT && rhs.state == Lattice::CONSTANT) {
+                // An operation which traps is left for runtime
+                bool isSafe = evaluateOperator(instruction.op, lhs.value, rhs.value, instruction.type, result.value);
+                result.state = isSafe ? Lattice::CONSTANT : Lattice::OVERDEFINED;
+            }
+
+            update(instruction, result);
+            break;
+        }
+        case Opcode::PHI: {
+            Lattice result;
+
+            for (size_t i = 0; i < instruction.operands.size(); ++i) {
+                if (!m_executableEdges.count({instruction.incoming[i], instruction.parent})) continue;
+
+                Lattice operand = valueOf(instruction.operands[i]);
+                if (operand.state == Lattice::UNKNOWN) continue;
+
+                if (result.state == Lattice::UNKNOWN) {
+                    result = operand;
+                } else if (operand.state == Lattice::OVERDEFINED || operand.value != result.value) {
+                    result.state = Lattice::OVERDEFINED;
+                    break;
+                }
+            }
+
+            update(instruction, result);
+            break;
+        }
+        case Opcode::UNDEF:
+        case Opcode::LOAD:
+            update(instruction, Lattice{Lattice::OVERDEFINED, 0});
+            break;
+        case Opcode::JUMP:
+            markEdge(instruction.parent, instruction.targets[0]);
+            break;
+        case Opcode::BRANCH: {
+            Lattice condition = valueOf(instruction.operands[0]);
+
+            if (condition.state == Lattice::CONSTANT) {
+                markEdge(instruction.parent, instruction.targets[condition.value != 0 ? 0 : 1]);
+            } else if (condition.state == Lattice::OVERDEFINED) {
+                markEdge(instruction.parent, instruction.targets[0]);
+                markEdge(instruction.parent, instruction.targets[1]);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void ConditionalConstantPropagator::markEdge(BasicBlock* from, BasicBlock* to) {
+    if (m_executableEdges.insert({from, to}).second) m_edgeWorklist.emplace_back(from, to);
+}
+
+// Values only go down the lattice, so every instruction changes at most twice
+void ConditionalConstantPropagator::update(Instruction& instruction, Lattice value) {
+    Lattice& current = m_values[&instruction];
+    if (current.state == value.state && current.value == value.value) return;
+
+    current = value;
+
+    for (Instruction* user : m_users[&instruction]) {
+        m_valueWorklist.push_back(user);
+    }
+}
+
+ConditionalConstantPropagator::Lattice ConditionalConstantPropagator::valueOf(Instruction* instruction) const {
+    auto found = m_values.find(instruction);
+    return found != m_values.end() ? found->second : Lattice{};
+}
+
+void ConditionalConstantPropagator::rewrite(IRFunction& function) {
+    std::vector<Instruction*> constants;
+    std::vector<std::pair<Instruction*, bool>> branches; // With the direction taken
+
+    for (const auto& block : function.blocks()) {
+        if (!m_executableBlocks.count(block.get())) continue;
+
+        for (const auto& instruction : block->instructions) {
+            Lattice value = valueOf(instruction.get());
+
+            if (instruction->opcode == Opcode::BRANCH && valueOf(instruction->operands[0]).state == Lattice::CONSTANT) {
+                branches.emplace_back(instruction.get(), valueOf(instruction->operands[0]).value != 0);
+            } else if (instruction->opcode != Opcode::CONST && value.state == Lattice::CONSTANT) {
+                constants.push_back(instruction.get());
+            }
+        }
+    }
+
+    // The constants are placed in the entry block, which dominates every use
+    for (Instruction* instruction : constants) {
+        auto constant = std::make_unique<Instruction>();
+        constant->opcode = Opcode::CONST;
+        constant->type = instruction->type;
+        constant->constant = m_values[instruction].value;
+
+        function.replaceAllUses(instruction, function.prepend(function.entry(), std::move(constant)));
+        function.erase(instruction);
+        ++m_constantCount;
+    }
+
+    for (auto [branch, isTrue] : branches) {
+        BasicBlock *taken = branch->targets[isTrue ? 0 : 1];
+        BasicBlock *skipped = branch->targets[isTrue ? 1 : 0];
+
+        function.removeEdge(branch->parent, skipped);
+        branch->opcode = Opcode::JUMP;
+        branch->operands.clear();
+        branch->targets = {taken};
+        ++m_foldedBranchCount;
+    }
+
+    m_removedBlockCount += function.removeUnreachableBlocks();
+    function.removeTrivialPhis();
+    function.removeUnusedValues();
+}
@@ -0,0 +1,195 @@
+#include "ir.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+bool Instruction::isTerminator() const {
+    return opcode == Opcode::JUMP || opcode == Opcode::BRANCH || opcode == Opcode::RETURN;
+}
+
+bool Instruction::hasResult() const {
+    return type != ASTNode::DataType::UNKNOWN;
+}
+
+bool Instruction::hasSideEffects() const {
+    switch (opcode) {
+        case Opcode::BINARY:
+            // Division by zero and shifts out of range are runtime errors
+            return op == ASTNode::OperatorType::DIV || op == ASTNode::OperatorType::MOD ||
+                op == ASTNode::OperatorType::BLS || op == ASTNode::OperatorType::BRS;
+        case Opcode::LOAD:
+            // The index may be out of bounds
+            return true;
+        case Opcode::CONST:
+        case Opcode::UNDEF:
+        case Opcode::CONVERT:
+        case Opcode::PHI:
+            return false;
+        default:
+            return true;
+    }
+}
+
+Instruction* BasicBlock::terminator() const {
+    if (instructions.empty() || !instructions.back()->isTerminator()) return nullptr;
+    return instructions.back().get();
+}
+
+BasicBlock* IRFunction::createBlock() {
+    auto block = std::make_unique<BasicBlock>();
+    block->id = m_nextBlockId++;
+    m_blocks.push_back(std::move(block));
+    return m_blocks.back().get();
+}
+
+BasicBlock* IRFunction::entry() const {
+    return m_blocks.front().get();
+}
+
+const std::vector<std::unique_ptr<BasicBlock>>& IRFunction::blocks() const {
+    return m_blocks;
+}
+
+Instruction* IRFunction::append(BasicBlock* block, std::unique_ptr<Instruction> instruction) {
+    instruction->parent = block;
+    instruction->id = m_nextValueId++;
+    block->instructions.push_back(std::move(instruction));
+    return block->instructions.back().get();
+}
+
+Instruction* IRFunction::prepend(BasicBlock* block, std::unique_ptr<Instruction> instruction) {
+    auto position = std::find_if(block->instructions.begin(), block->instructions.end(), [](const auto& existing) {
+        return existing->opcode != Opcode::PHI;
+    });
+
+    instruction->parent = block;
+    instruction->id = m_nextValueId++;
+    return block->instructions.insert(position, std::move(instruction))->get();
+}
+
+void IRFunction::erase(Instruction* instruction) {
+    auto& instructions = instruction->parent->instructions;
+    instructions.erase(std::find_if(instructions.begin(), instructions.end(), [instruction](const auto& existing) {
+        return existing.get() == instruction;
+    }));
+}
+
+void IRFunction::addEdge(BasicBlock* from, BasicBlock* to) {
+    from->successors.push_back(to);
+    to->predecessors.push_back(from);
+}
+
+void IRFunction::removeEdge(BasicBlock* from, BasicBlock* to) {
+    from->successors.erase(std::find(from->successors.begin(), from->successors.end(), to));
+    to->predecessors.erase(std::find(to->predecessors.begin(), to->predecessors.end(), from));
+
+    for (auto& instruction : to->instructions) {
+        if (instruction->opcode != Opcode::PHI) break;
+
+        auto position = std::find(instruction->incoming.begin(), instruction->incoming.end(), from);
+        instruction->operands.erase(instruction->operands.begin() + (position - instruction->incoming.begin()));
+        instruction->incoming.erase(position);
+    }
+}
+
+void IRFunction::replaceAllUses(Instruction* from, Instruction* to) {
+    for (auto& block : m_blocks) {
+        for (auto& instruction : block->instructions) {
+            std::replace(instruction->operands.begin(), instruction->operands.end(), from, to);
+        }
+    }
+}
+
+size_t IRFunction::removeUnreachableBlocks() {
+    std::unordered_set<BasicBlock*> reachable{entry()};
+    std::vector<BasicBlock*> pending{entry()};
+
+    while (!pending.empty()) {
+        BasicBlock *block = pending.back();
+        pending.pop_back();
+
+        for (BasicBlock* successor : block->successors) {
+            if (reachable.insert(successor).second) pending.push_back(successor);
+        }
+    }
+
+    // Edges out of the removed blocks go first, the phis of reachable blocks lose their operands
+    for (auto& block : m_blocks) {
+        if (reachable.count(block.get())) continue;
+
+        while (!block->successors.empty()) {
+            removeEdge(block.get(), block->successors.back());
+        }
+    }
+
+    size_t count = m_blocks.size() - reachable.size();
+    std::erase_if(m_blocks, [&reachable](const auto& block) { return !reachable.count(block.get()); });
+    return count;
+}
+
+void IRFunction::removeTrivialPhis() {
+    for (bool isChanged = true; isChanged;) {
+        isChanged = false;
+
+        for (auto& block : m_blocks) {
+            for (size_t i = 0; i < block->instructions.size() && block->instructions[i]->opcode == Opcode::PHI;) {
+                Instruction *phi = block->instructions[i].get();
+                Instruction *value = nullptr;
+                bool isTrivial = true;
+
+                for (Instruction* operand : phi->operands) {
+                    if (operand == phi || operand == value) continue;
+                    if (value) isTrivial = false;
+                    value = operand;
+                }
+
+                // A phi merging nothing is left to the verifier
+                if (!isTrivial || !value) {
+                    ++i;
+                    continue;
+                }
+
+                replaceAllUses(phi, value);
+                erase(phi);
+                isChanged = true;
+            }
+        }
+    }
+}
+
+size_t IRFunction::removeUnusedValues() {
+    std::unordered_map<Instruction*, size_t> useCounts;
+
+    for (auto& block : m_blocks) {
+        for (auto& instruction : block->instructions) {
+            for (Instruction* operand : instruction->operands) {
+                ++useCounts[operand];
+            }
+        }
+    }
+
+    std::vector<Instruction*> pending;
+    for (auto& block : m_blocks) {
+        for (auto& instruction : block->instructions) {
+            if (!instruction->hasSideEffects() && !useCounts[instruction.get()]) pending.push_back(instruction.get());
+        }
+    }
+
+    // Removing a value may leave its operands unused
+    size_t count = 0;
+
+    while (!pending.empty()) {
+        Instruction *instruction = pending.back();
+        pending.pop_back();
+
+        for (Instruction* operand : instruction->operands) {
+            if (operand != instruction && --useCounts[operand] == 0 && !operand->hasSideEffects()) pending.push_back(operand);
+        }
+
+        erase(instruction);
+        ++count;
+    }
+
+    return count;
+}
@@ -0,0 +1,397 @@
+#include "ir_builder.hpp"
+#include "arithmetic.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace {
+
+// Scalar variables declared or stored to inside a loop, in the order they're found
+class WrittenVariables : public Traversal {
+public:
+    std::vector<std::pair<const Symbol*, std::string>> collect(ForNode& loop) {
+        traverse(loop);
+        return std::move(m_variables);
+    }
+
+private:
+    bool preVisit(ASTNode& node) override {
+        if (dynamic_cast<ExpressionNode*>(&node)) return false;
+
+        IdentifierNode *identifier = nullptr;
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            identifier = dynamic_cast<IdentifierNode*>(assignment->left.get());
+        } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+            identifier = varDecl->identifier.get();
+        } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+            identifier = arrayDecl->identifier.get();
+        }
+
+        if (identifier == nullptr) return true;
+
+        // An array declaration initializes the promoted elements of the array
+        if (!identifier->symbolPtr->isArray) add(identifier->symbolPtr, identifier->name);
+        for (const Symbol* element : identifier->symbolPtr->details().promotedElements) {
+            add(element, identifier->name + "[" + std::to_string(element->details().elementIndex) + "]");
+        }
+
+        return true;
+    }
+
+    void add(const Symbol* symbol, const std::string& name) {
+        auto found = std::find_if(m_variables.begin(), m_variables.end(), [symbol](const auto& variable) {
+            return variable.first == symbol;
+        });
+
+        if (found == m_variables.end()) m_variables.emplace_back(symbol, name);
+    }
+
+    std::vector<std::pair<const Symbol*, std::string>> m_variables;
+};
+
+} // namespace
+
+std::unique_ptr<IRFunction> IRBuilder::build(ASTNode& root) {
+    m_function = std::make_unique<IRFunction>();
+    m_block = m_function->createBlock();
+    m_definitions.clear();
+    m_undefined.clear();
+    m_declaredArrays.clear();
+
+    traverse(root);
+    emit(Opcode::RETURN, ASTNode::DataType::UNKNOWN, {});
+
+    // Code after a loop without a condition is never run
+    m_function->removeUnreachableBlocks();
+    m_function->removeTrivialPhis();
+    return std::move(m_function);
+}
+
+// Statements are lowered whole when they're reached, loops step by step
+bool IRBuilder::preVisit(ASTNode& node) {
+    if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+        lowerAssignment(*assignment);
+        return false;
+    }
+
+    if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+        lowerVariableDecl(*varDecl);
+        return false;
+    }
+
+    if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+        lowerArrayDecl(*arrayDecl);
+        return false;
+    }
+
+    return !dynamic_cast<ExpressionNode*>(&node) && !dynamic_cast<TypedefNode*>(&node) &&
+        !dynamic_cast<EmptyStatementNode*>(&node);
+}
+
+// Steps of a loop: 0 - init and header, 1 - increment and back edge
+ASTNode* IRBuilder::nextChild(ASTNode& node, size_t& step) {
+    auto loop = dynamic_cast<ForNode*>(&node);
+    if (loop == nullptr) return node.child(step++);
+
+    if (step++ == 0) {
+        if (loop->init) lowerAssignment(*loop->init);
+        enterLoop(*loop);
+        return loop->body.get();
+    }
+
+    leaveLoop(*loop);
+    return nullptr;
+}
+
+void IRBuilder::enterLoop(ForNode& loop) {
+    BasicBlock *header = m_function->createBlock();
+    std::vector<Instruction*> entryValues;
+    auto variables = WrittenVariables().collect(loop);
+
+    for (const auto& variable : variables) {
+        entryValues.push_back(valueOf(variable.first));
+    }
+
+    BasicBlock *preheader = m_block;
+    jump(header);
+    m_block = header;
+
+    Loop state{header, nullptr, {}};
+
+    for (size_t i = 0; i < variables.size(); ++i) {
+        Instruction *phi = emit(Opcode::PHI, variables[i].first->type, {entryValues[i]});
+        phi->incoming.push_back(preheader);
+        phi->variable = variables[i].first;
+        phi->name = variables[i].second;
+
+        m_definitions[phi->variable] = phi;
+        state.phis.push_back(phi);
+    }
+
+    BasicBlock *body = m_function->createBlock();
+    state.exit = m_function->createBlock();
+
+    if (loop.condition) {
+        Instruction *branch = emit(Opcode::BRANCH, ASTNode::DataType::UNKNOWN, {lowerExpression(*loop.condition)});
+        branch->targets = {body, state.exit};
+        m_function->addEdge(header, body);
+        m_function->addEdge(header, state.exit);
+    } else {
+        jump(body);
+    }
+
+    m_loops.push_back(std::move(state));
+    m_block = body;
+}
+
+void IRBuilder::leaveLoop(ForNode& loop) {
+    Loop state = std::move(m_loops.back());
+    m_loops.pop_back();
+
+    if (loop.increment) lowerAssignment(*loop.increment);
+
+    for (Instruction* phi : state.phis) {
+        phi->operands.push_back(valueOf(phi->variable));
+        phi->incoming.push_back(m_block);
+    }
+
+    jump(state.header);
+
+    // The exit is only reached from the header
+    for (Instruction* phi : state.phis) {
+        m_definitions[phi->variable] = phi;
+    }
+
+    m_block = state.exit;
+}
+
+// The value is computed first, then the index of an element target
+void IRBuilder::lowerAssignment(AssignmentNode& node) {
+    Instruction *value = lowerExpression(*node.right);
+
+    if (auto element = dynamic_cast<ArrayIndexNode*>(node.left.get())) {
+        Symbol *array = element->identifier->symbolPtr;
+        Instruction *index = lowerExpression(*element->indexExpression);
+        declareEvaluated(array, element->identifier->name);
+        Instruction *store = emit(Opcode::STORE, ASTNode::DataType::UNKNOWN, {index, convert(value, array->type)});
+        store->array = array;
+        store->name = element->identifier->name;
+    } else if (auto identifier = dynamic_cast<IdentifierNode*>(node.left.get())) {
+        m_definitions[identifier->symbolPtr] = convert(value, identifier->symbolPtr->type);
+    }
+}
+
+void IRBuilder::lowerVariableDecl(VariableDeclNode& node) {
+    Symbol *symbol = node.identifier->symbolPtr;
+
+    // A typedef-name can stand for an array type
+    if (symbol->isArray) {
+        Instruction *declaration = emit(Opcode::ARRAY, ASTNode::DataType::UNKNOWN, {});
+        declaration->array = symbol;
+        declaration->name = node.identifier->name;
+        m_declaredArrays.insert(symbol);
+
+        for (const Symbol* element : symbol->details().promotedElements) {
+            m_definitions[element] = undefined(element->type);
+        }
+        return;
+    }
+
+    // Declarations inside loops start over on every iteration
+    m_definitions[symbol] = node.initExpression
+        ? convert(lowerExpression(*node.initExpression), symbol->type)
+        : undefined(symbol->type);
+}
+
+void IRBuilder::lowerArrayDecl(ArrayDeclNode& node) {
+    Symbol *symbol = node.identifier->symbolPtr;
+    std::vector<Instruction*> initializers;
+
+    if (node.stringLiteralInit) {
+        const std::string& text = node.stringLiteralInit->value;
+        size_t length = std::min(text.size(), static_cast<size_t>(symbol->arraySize));
+
+        for (size_t i = 0; i < length; ++i) {
+            initializers.push_back(constant(text[i], ASTNode::DataType::CHAR));
+        }
+    }
+
+    for (auto& expression : node.braceListInit) {
+        initializers.push_back(convert(lowerExpression(*expression), symbol->type));
+    }
+
+    Instruction *declaration = emit(Opcode::ARRAY, ASTNode::DataType::UNKNOWN, initializers);
+    declaration->array = symbol;
+    declaration->name = node.identifier->name;
+    declaration->isZeroFilled = node.stringLiteralInit || !node.braceListInit.empty();
+    m_declaredArrays.insert(symbol);
+
+    // The promoted elements take their initial values as scalars
+    for (const Symbol* element : symbol->details().promotedElements) {
+        size_t index = static_cast<size_t>(element->details().elementIndex);
+
+        if (index < initializers.size()) {
+            m_definitions[element] = initializers[index];
+        } else {
+            m_definitions[element] = declaration->isZeroFilled ? constant(0, element->type) : undefined(element->type);
+        }
+    }
+}
+
+Instruction* IRBuilder::lowerExpression(ExpressionNode& root) {
+    std::vector<std::pair<ExpressionNode*, bool>> nodes{{&root, false}};
+    std::vector<Instruction*> values;
+
+    while (!nodes.empty()) {
+        auto [node, isExpanded] = nodes.back();
+        nodes.pop_back();
+
+        auto binary = dynamic_cast<BinaryOpNode*>(node);
+        auto element = dynamic_cast<ArrayIndexNode*>(node);
+
+        if (binary && !isExpanded) {
+            nodes.emplace_back(node, true);
+            nodes.emplace_back(binary->right.get(), false);
+            nodes.emplace_back(binary->left.get(), false);
+        } else if (element && !isExpanded) {
+            nodes.emplace_back(node, true);
+            nodes.emplace_back(element->indexExpression.get(), false);
+        } else if (binary) {
+            Instruction *rhs = values.back();
+            values.pop_back();
+            values.back() = emit(Opcode::BINARY, binary->resolvedType, {values.back(), rhs});
+            values.back()->op = binary->op;
+        } else if (element) {
+            declareEvaluated(element->identifier->symbolPtr, element->identifier->name);
+            Instruction *load = emit(Opcode::LOAD, element->resolvedType, {values.back()});
+            load->array = element->identifier->symbolPtr;
+            load->name = element->identifier->name;
+            values.back() = load;
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+            values.push_back(valueOf(identifier->symbolPtr));
+        } else {
+            int64_t value = 0;
+            constantValue(node, value);
+            values.push_back(constant(value, node->resolvedType));
+        }
+    }
+
+    return values.back();
+}
+
+Instruction* IRBuilder::emit(Opcode opcode, ASTNode::DataType type, std::vector<Instruction*> operands) {
+    auto instruction = std::make_unique<Instruction>();
+    instruction->opcode = opcode;
+    instruction->type = type;
+    instruction->operands = std::move(operands);
+    return m_function->append(m_block, std::move(instruction));
+}
+
+Instruction* IRBuilder::constant(int64_t value, ASTNode::DataType type) {
+    Instruction *instruction = emit(Opcode::CONST, type, {});
+    instruction->constant = value;
+    return instruction;
+}
+
+// Stores narrow the value to the type of the target
+Instruction* IRBuilder::convert(Instruction* value, ASTNode::DataType type) {
+    if (value->type == type) return value;
+    return emit(Opcode::CONVERT, type, {value});
+}
+
+// Placed in the entry block, so that it's available everywhere
+Instruction* IRBuilder::undefined(ASTNode::DataType type) {
+    auto found = m_undefined.find(type);
+    if (found != m_undefined.end()) return found->second;
+
+    auto instruction = std::make_unique<Instruction>();
+    instruction->opcode = Opcode::UNDEF;
+    instruction->type = type;
+    return m_undefined[type] = m_function->prepend(m_function->entry(), std::move(instruction));
+}
+
+void IRBuilder::jump(BasicBlock* target) {
+    Instruction *instruction = emit(Opcode::JUMP, ASTNode::DataType::UNKNOWN, {});
+    instruction->targets = {target};
+    m_function->addEdge(m_block, target);
+}
+
+Instruction* IRBuilder::valueOf(const Symbol* symbol) {
+    auto found = m_definitions.find(symbol);
+    if (found != m_definitions.end()) return found->second;
+
+    // A value left by partial evaluation holds until the symbol is written, so it's placed in the entry block
+    if (!std::holds_alternative<std::monostate>(symbol->slot().value)) {
+        auto instruction = std::make_unique<Instruction>();
+        instruction->opcode = Opcode::CONST;
+        instruction->type = symbol->type;
+        instruction->constant = std::visit([](auto value) -> int64_t {
+            if constexpr (std::is_same_v<decltype(value), std::monostate>) return 0;
+            else return value;
+        }, symbol->slot().value);
+
+        return m_definitions[symbol] = m_function->prepend(m_function->entry(), std::move(instruction));
+    }
+
+    return undefined(symbol->type);
+}
+
+// An array declared by a statement partial evaluation ran is declared again in the entry block, with
+// the values the run left in it; the ones it left uninitialized are undefined
+void IRBuilder::declareEvaluated(Symbol* array, const std::string& name) {
+    if (!m_declaredArrays.insert(array).second) return;
+
+    const Symbol& slot = array->slot();
+    ASTNode::DataType storageType = array->details().storageType;
+    bool isPacked = storageType != ASTNode::DataType::UNKNOWN;
+    size_t size = isPacked ? slot.details().initializedValues.size() : slot.arrayValues.size();
+
+    // Left undeclared for the verifier when no run declared it
+    if (size == 0) return;
+
+    std::vector<std::optional<int64_t>> values;
+    for (size_t i = 0; i < std::min(size, static_cast<size_t>(array->arraySize)); ++i) {
+        if (isPacked) {
+            if (!slot.details().initializedValues[i]) values.emplace_back();
+            else values.emplace_back(unpackValue(storageType, &slot.details().packedValues[i * typeSize(storageType)]));
+        } else {
+            values.push_back(std::visit([](auto value) -> std::optional<int64_t> {
+                if constexpr (std::is_same_v<decltype(value), std::monostate>) return std::nullopt;
+                else return value;
+            }, slot.arrayValues[i]));
+        }
+    }
+
+    // The elements past the last initialized one are undefined; when all are initialized, the zeros at the end are filled
+    while (!values.empty() && !values.back()) values.pop_back();
+    bool isZeroFilled = false;
+
+    if (values.size() == static_cast<size_t>(array->arraySize)) {
+        while (!values.empty() && values.back() == 0) {
+            values.pop_back();
+            isZeroFilled = true;
+        }
+    }
+
+    auto declaration = std::make_unique<Instruction>();
+    declaration->opcode = Opcode::ARRAY;
+    declaration->array = array;
+    declaration->name = name;
+    declaration->isZeroFilled = isZeroFilled;
+    declaration->operands.resize(values.size());
+    Instruction *instruction = m_function->prepend(m_function->entry(), std::move(declaration));
+
+    // Prepended after the declaration and backwards, so they come before it in order
+    for (size_t i = values.size(); i-- > 0;) {
+        if (!values[i]) {
+            instruction->operands[i] = undefined(array->type);
+            continue;
+        }
+
+        auto constant = std::make_unique<Instruction>();
+        constant->opcode = Opcode::CONST;
+        constant->type = array->type;
+        constant->constant = *values[i];
+        instruction->operands[i] = m_function->prepend(m_function->entry(), std::move(constant));
+    }
+}
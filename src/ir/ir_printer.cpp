@@ -0,0 +1,116 @@
+#include "ir_printer.hpp"
+
+IRPrinter::IRPrinter(std::ostream& output) :
+    m_output(output)
+{}
+
+void IRPrinter::print(const IRFunction& function) {
+    m_output << "function main" << std::endl;
+
+    for (const auto& block : function.blocks()) {
+        m_output << "bb" << block->id << ":";
+
+        if (!block->predecessors.empty()) {
+            m_output << " ; preds";
+            for (const BasicBlock* predecessor : block->predecessors) {
+                m_output << " bb" << predecessor->id;
+            }
+        }
+
+        m_output << std::endl;
+
+        for (const auto& instruction : block->instructions) {
+            printInstruction(*instruction);
+        }
+    }
+}
+
+void IRPrinter::printInstruction(const Instruction& instruction) {
+    m_output << "  ";
+    if (instruction.hasResult()) {
+        m_output << "%" << instruction.id << " = ";
+    }
+
+    m_output << mnemonic(instruction);
+    if (instruction.hasResult()) {
+        m_output << " " << ASTNode::typeToString(instruction.type);
+    }
+
+    auto value = [](const Instruction* operand) { return "%" + std::to_string(operand->id); };
+
+    switch (instruction.opcode) {
+        case Opcode::CONST:
+            m_output << " " << instruction.constant;
+            break;
+        case Opcode::PHI:
+            for (size_t i = 0; i < instruction.operands.size(); ++i) {
+                m_output << (i ? ", [" : " [") << value(instruction.operands[i]) << ", bb" << instruction.incoming[i]->id << "]";
+            }
+            m_output << " ; " << instruction.name;
+            break;
+        case Opcode::LOAD:
+            m_output << " @" << instruction.name << "[" << value(instruction.operands[0]) << "]";
+            break;
+        case Opcode::STORE:
+            m_output << " @" << instruction.name << "[" << value(instruction.operands[0]) << "], " << value(instruction.operands[1]);
+            break;
+        case Opcode::ARRAY:
+            m_output << " @" << instruction.name << "[" << instruction.array->arraySize << "]";
+            if (instruction.array->details().storageType != ASTNode::DataType::UNKNOWN) {
+                m_output << " as " << ASTNode::typeToString(instruction.array->details().storageType);
+            }
+            if (!instruction.operands.empty() || instruction.isZeroFilled) {
+                m_output << " {";
+                for (size_t i = 0; i < instruction.operands.size(); ++i) {
+                    m_output << (i ? ", " : "") << value(instruction.operands[i]);
+                }
+                m_output << (instruction.isZeroFilled ? ", 0...}" : "}");
+            }
+            break;
+        case Opcode::JUMP:
+            m_output << " bb" << instruction.targets[0]->id;
+            break;
+        case Opcode::BRANCH:
+            m_output << " " << value(instruction.operands[0]) << ", bb" << instruction.targets[0]->id
+                << ", bb" << instruction.targets[1]->id;
+            break;
+        default:
+            for (size_t i = 0; i < instruction.operands.size(); ++i) {
+                m_output << (i ? ", " : " ") << value(instruction.operands[i]);
+            }
+    }
+
+    m_output << std::endl;
+}
+
+std::string IRPrinter::mnemonic(const Instruction& instruction) {
+    switch (instruction.opcode) {
+        case Opcode::CONST:   return "const";
+        case Opcode::UNDEF:   return "undef";
+        case Opcode::CONVERT: return "convert";
+        case Opcode::PHI:     return "phi";
+        case Opcode::LOAD:    return "load";
+        case Opcode::STORE:   return "store";
+        case Opcode::ARRAY:   return "array";
+        case Opcode::JUMP:    return "jump";
+        case Opcode::BRANCH:  return "branch";
+        case Opcode::RETURN:  return "return";
+        default: break;
+    }
+
+    switch (instruction.op) {
+        case ASTNode::OperatorType::ADD:  return "add";
+        case ASTNode::OperatorType::SUB:  return "sub";
+        case ASTNode::OperatorType::MULT: return "mul";
+        case ASTNode::OperatorType::DIV:  return "div";
+        case ASTNode::OperatorType::MOD:  return "mod";
+        case ASTNode::OperatorType::EQ:   return "eq";
+        case ASTNode::OperatorType::NEQ:  return "ne";
+        case ASTNode::OperatorType::LT:   return "lt";
+        case ASTNode::OperatorType::LE:   return "le";
+        case ASTNode::OperatorType::GT:   return "gt";
+        case ASTNode::OperatorType::GE:   return "ge";
+        case ASTNode::OperatorType::BLS:  return "shl";
+        default:                          return "shr";
+    }
+}
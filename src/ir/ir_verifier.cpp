@@ -0,0 +1,227 @@
+#include "ir_verifier.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+bool IRVerifier::verify(const IRFunction& function) {
+    m_errors.clear();
+    m_positions.clear();
+
+    for (const auto& block : function.blocks()) {
+        for (size_t i = 0; i < block->instructions.size(); ++i) {
+            m_positions[block->instructions[i].get()] = i;
+        }
+    }
+
+    if (!function.entry()->predecessors.empty()) fail(*function.entry(), "the entry block has predecessors");
+
+    for (const auto& block : function.blocks()) {
+        verifyBlock(*block);
+    }
+
+    // Dominance is only meaningful once the edges are right
+    if (m_errors.empty()) verifyDominance(function);
+    return m_errors.empty();
+}
+
+const std::vector<std::string>& IRVerifier::errors() const {
+    return m_errors;
+}
+
+void IRVerifier::verifyBlock(const BasicBlock& block) {
+    const Instruction *terminator = block.terminator();
+    if (terminator == nullptr) {
+        fail(block, "the block doesn't end with a terminator");
+        return;
+    }
+
+    bool isPhiAllowed = true;
+
+    for (const auto& instruction : block.instructions) {
+        if (instruction->parent != &block) fail(block, "%" + std::to_string(instruction->id) + " has a wrong parent");
+        if (instruction->isTerminator() && instruction.get() != terminator) fail(block, "a terminator isn't last");
+
+        if (instruction->opcode == Opcode::PHI) {
+            if (!isPhiAllowed) fail(block, "phi %" + std::to_string(instruction->id) + " follows other instructions");
+
+            std::vector<BasicBlock*> incoming = instruction->incoming;
+            std::vector<BasicBlock*> predecessors = block.predecessors;
+            std::sort(incoming.begin(), incoming.end());
+            std::sort(predecessors.begin(), predecessors.end());
+
+            if (incoming != predecessors || instruction->operands.size() != instruction->incoming.size()) {
+                fail(block, "phi %" + std::to_string(instruction->id) + " doesn't have an operand per predecessor");
+            }
+        } else {
+            isPhiAllowed = false;
+        }
+
+        verifyInstruction(*instruction);
+    }
+
+    if (block.successors != terminator->targets) fail(block, "the successors don't match the terminator");
+
+    for (const BasicBlock* successor : block.successors) {
+        const auto& predecessors = successor->predecessors;
+        if (std::count(predecessors.begin(), predecessors.end(), &block) != std::count(block.successors.begin(), block.successors.end(), successor)) {
+            fail(block, "the edge to bb" + std::to_string(successor->id) + " is missing from its predecessors");
+        }
+    }
+}
+
+void IRVerifier::verifyInstruction(const Instruction& instruction) {
+    const BasicBlock& block = *instruction.parent;
+    std::string name = "%" + std::to_string(instruction.id);
+
+    size_t operandCount = 0;
+    size_t targetCount = 0;
+    bool isTyped = true;
+    bool isMemory = false;
+
+    switch (instruction.opcode) {
+        case Opcode::CONST:
+        case Opcode::UNDEF:   break;
+        case Opcode::BINARY:  operandCount = 2; break;
+        case Opcode::CONVERT: operandCount = 1; break;
+        case Opcode::PHI:     operandCount = instruction.operands.size(); break;
+        case Opcode::LOAD:    operandCount = 1; isMemory = true; break;
+        case Opcode::STORE:   operandCount = 2; isMemory = true; isTyped = false; break;
+        case Opcode::ARRAY:   operandCount = instruction.operands.size(); isMemory = true; isTyped = false; break;
+        case Opcode::JUMP:    targetCount = 1; isTyped = false; break;
+        case Opcode::BRANCH:  operandCount = 1; targetCount = 2; isTyped = false; break;
+        case Opcode::RETURN:  isTyped = false; break;
+    }
+
+    if (instruction.operands.size() != operandCount) fail(block, name + " has a wrong number of operands");
+    if (instruction.targets.size() != targetCount) fail(block, name + " has a wrong number of targets");
+    if (instruction.hasResult() != isTyped) fail(block, name + (isTyped ? " has no type" : " shouldn't have a result"));
+    if ((instruction.array != nullptr) != isMemory) fail(block, name + (isMemory ? " has no array" : " shouldn't refer to an array"));
+
+    for (const Instruction* operand : instruction.operands) {
+        if (!operand || !m_positions.count(operand)) {
+            fail(block, name + " uses a value which isn't in the function");
+        } else if (!operand->hasResult()) {
+            fail(block, name + " uses %" + std::to_string(operand->id) + ", which has no result");
+        }
+    }
+}
+
+// A value must be defined on every path to its use; a phi operand on every path to its incoming block.
+// An array must be declared on every path to its loads and stores.
+void IRVerifier::verifyDominance(const IRFunction& function) {
+    computeDominators(function);
+
+    std::unordered_map<const Symbol*, std::vector<const Instruction*>> declarations;
+    for (const auto& block : function.blocks()) {
+        for (const auto& instruction : block->instructions) {
+            if (instruction->opcode == Opcode::ARRAY) declarations[instruction->array].push_back(instruction.get());
+        }
+    }
+
+    for (const auto& block : function.blocks()) {
+        if (!m_idom.count(block.get())) {
+            fail(*block, "the block can't be reached from the entry");
+            continue;
+        }
+
+        for (const auto& instruction : block->instructions) {
+            for (size_t i = 0; i < instruction->operands.size(); ++i) {
+                const Instruction *operand = instruction->operands[i];
+                const BasicBlock *user = instruction->opcode == Opcode::PHI ? instruction->incoming[i] : block.get();
+
+                bool isDominated = operand->parent == user && instruction->opcode != Opcode::PHI
+                    ? m_positions.at(operand) < m_positions.at(instruction.get())
+                    : dominates(operand->parent, user);
+
+                if (!isDominated) {
+                    fail(*block, "%" + std::to_string(instruction->id) + " uses %" + std::to_string(operand->id) +
+                        ", which doesn't dominate it");
+                }
+            }
+
+            if (instruction->opcode != Opcode::LOAD && instruction->opcode != Opcode::STORE) continue;
+
+            const auto& candidates = declarations[instruction->array];
+            bool isDeclared = std::any_of(candidates.begin(), candidates.end(), [&](const Instruction* declaration) {
+                return declaration->parent == block.get()
+                    ? m_positions.at(declaration) < m_positions.at(instruction.get())
+                    : dominates(declaration->parent, block.get());
+            });
+
+            if (!isDeclared) {
+                fail(*block, "%" + std::to_string(instruction->id) + " accesses @" + instruction->name +
+                    ", which isn't declared on every path to it");
+            }
+        }
+    }
+}
+
+// Cooper, Harvey and Kennedy: iterate over the blocks in reverse postorder until the tree settles
+void IRVerifier::computeDominators(const IRFunction& function) {
+    std::vector<const BasicBlock*> postorder;
+    std::unordered_set<const BasicBlock*> visited{function.entry()};
+    std::vector<std::pair<const BasicBlock*, size_t>> stack{{function.entry(), 0}};
+
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+
+        if (next < block->successors.size()) {
+            const BasicBlock *successor = block->successors[next++];
+            if (visited.insert(successor).second) stack.emplace_back(successor, 0);
+        } else {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+
+    std::unordered_map<const BasicBlock*, size_t> order;
+    for (size_t i = 0; i < postorder.size(); ++i) {
+        order[postorder[i]] = i;
+    }
+
+    m_idom.clear();
+    m_idom[function.entry()] = function.entry();
+
+    auto intersect = [&](const BasicBlock* lhs, const BasicBlock* rhs) {
+        while (lhs != rhs) {
+            while (order[lhs] < order[rhs]) lhs = m_idom[lhs];
+            while (order[rhs] < order[lhs]) rhs = m_idom[rhs];
+        }
+        return lhs;
+    };
+
+    for (bool isChanged = true; isChanged;) {
+        isChanged = false;
+
+        for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+            const BasicBlock *block = *it;
+            if (block == function.entry()) continue;
+
+            const BasicBlock *idom = nullptr;
+            for (const BasicBlock* predecessor : block->predecessors) {
+                if (!m_idom.count(predecessor)) continue;
+                idom = idom ? intersect(predecessor, idom) : predecessor;
+            }
+
+            auto current = m_idom.find(block);
+            if (current == m_idom.end() || current->second != idom) {
+                m_idom[block] = idom;
+                isChanged = true;
+            }
+        }
+    }
+}
+
+bool IRVerifier::dominates(const BasicBlock* dominator, const BasicBlock* block) const {
+    while (true) {
+        if (block == dominator) return true;
+
+        const BasicBlock *parent = m_idom.at(block);
+        if (parent == block) return false;
+        block = parent;
+    }
+}
+
+void IRVerifier::fail(const BasicBlock& block, const std::string& message) {
+    m_errors.push_back("bb" + std::to_string(block.id) + ": " + message);
+}
@@ -0,0 +1,269 @@
+#include "algebraic_simplifier.hpp"
+#include "arithmetic.hpp"
+#include "remarks.hpp"
+
+#include <format>
+
+using OperatorType = ASTNode::OperatorType;
+
+namespace {
+
+bool isConstantEqual(const ExpressionNode* node, int64_t expected) {
+    int64_t value;
+    return constantValue(node, value) && value == expected;
+}
+
+bool isConstant(const ExpressionNode* node) {
+    int64_t value;
+    return constantValue(node, value);
+}
+
+// Replace the operation owned by the slot with one of its own operands
+void replaceWithOperand(ExpressionSlot& slot, ExpressionSlot& operand) {
+    ExpressionSlot kept = std::move(operand);
+    slot = std::move(kept);
+}
+
+// x + 0, 0 + x, x - 0 -> x
+bool addZero(ExpressionSlot& slot) {
+    auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (binary == nullptr) return false;
+
+    if (binary->op != OperatorType::ADD && binary->op != OperatorType::SUB) return false;
+
+    if (isConstantEqual(binary->right.get(), 0) && binary->left->resolvedType == binary->resolvedType) {
+        replaceWithOperand(slot, binary->left);
+        return true;
+    }
+
+    if (binary->op == OperatorType::ADD && isConstantEqual(binary->left.get(), 0) &&
+        binary->right->resolvedType == binary->resolvedType)
+    {
+        replaceWithOperand(slot, binary->right);
+        return true;
+    }
+
+    return false;
+}
+
+// x * 1, 1 * x, x / 1 -> x
+bool multiplyOne(ExpressionSlot& slot) {
+    auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (binary == nullptr) return false;
+
+    if (binary->op != OperatorType::MULT && binary->op != OperatorType::DIV) return false;
+
+    if (isConstantEqual(binary->right.get(), 1) && binary->left->resolvedType == binary->resolvedType) {
+        replaceWithOperand(slot, binary->left);
+        return true;
+    }
+
+    if (binary->op == OperatorType::MULT && isConstantEqual(binary->left.get(), 1) &&
+        binary->right->resolvedType == binary->resolvedType)
+    {
+        replaceWithOperand(slot, binary->right);
+        return true;
+    }
+
+    return false;
+}
+
+// x * 0, 0 * x -> 0
+bool multiplyZero(ExpressionSlot& slot) {
+    auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (binary == nullptr || binary->op != OperatorType::MULT) return false;
+
+    bool isZero = (isConstantEqual(binary->right.get(), 0) && !mayTrap(binary->left.get())) ||
+                  (isConstantEqual(binary->left.get(), 0) && !mayTrap(binary->right.get()));
+    if (!isZero) return false;
+
+    slot = makeConstant(0, binary->resolvedType, *binary);
+    return true;
+}
+
+// x << 0, x >> 0 -> x
+bool shiftZero(ExpressionSlot& slot) {
+    auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (binary == nullptr) return false;
+
+    if (binary->op != OperatorType::BLS && binary->op != OperatorType::BRS) return false;
+    if (!isConstantEqual(binary->right.get(), 0) || binary->left->resolvedType != binary->resolvedType) return false;
+
+    replaceWithOperand(slot, binary->left);
+    return true;
+}
+
+// x - x -> 0
+bool subtractSelf(ExpressionSlot& slot) {
+    auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (binary == nullptr || binary->op != OperatorType::SUB) return false;
+
+    if (mayTrap(binary->left.get()) || !isSameExpression(binary->left.get(), binary->right.get())) return false;
+
+    slot = makeConstant(0, binary->resolvedType, *binary);
+    return true;
+}
+
+// x == x, x <= x, x >= x -> 1; x != x, x < x, x > x -> 0
+bool compareSelf(ExpressionSlot& slot) {
+    auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (binary == nullptr) return false;
+
+    int64_t result;
+
+    switch (binary->op) {
+        case OperatorType::EQ:
+        case OperatorType::LE:
+        case OperatorType::GE:
+            result = 1;
+            break;
+        case OperatorType::NEQ:
+        case OperatorType::LT:
+        case OperatorType::GT:
+            result = 0;
+            break;
+        default:
+            return false;
+    }
+
+    if (mayTrap(binary->left.get()) || !isSameExpression(binary->left.get(), binary->right.get())) return false;
+
+    slot = makeConstant(result, binary->resolvedType, *binary);
+    return true;
+}
+
+// c + x -> x + c, c * x -> x * c, c < x -> x > c: constants go to the right
+bool canonicalizeOperands(ExpressionSlot& slot) {
+    auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (binary == nullptr) return false;
+
+    if (!isConstant(binary->left.get()) || isConstant(binary->right.get())) return false;
+
+    switch (binary->op) {
+        case OperatorType::ADD:
+        case OperatorType::MULT:
+        case OperatorType::EQ:
+        case OperatorType::NEQ:
+            break;
+        case OperatorType::LT: binary->op = OperatorType::GT; break;
+        case OperatorType::LE: binary->op = OperatorType::GE; break;
+        case OperatorType::GT: binary->op = OperatorType::LT; break;
+        case OperatorType::GE: binary->op = OperatorType::LE; break;
+        default:
+            return false;
+    }
+
+    std::swap(binary->left, binary->right);
+    return true;
+}
+
+// (x + c1) + c2 -> x + (c1 + c2), (x - c1) + c2 -> x + (c2 - c1), (x * c1) * c2 -> x * (c1 * c2).
+// Arithmetic wraps modulo the width of the type, so regrouping keeps the narrowed result.
+bool reassociateConstants(ExpressionSlot& slot) {
+    auto outer = dynamic_cast<BinaryOpNode*>(slot.get());
+    if (outer == nullptr) return false;
+
+    auto inner = dynamic_cast<BinaryOpNode*>(outer->left.get());
+    if (inner == nullptr || inner->resolvedType != outer->resolvedType) return false;
+
+    int64_t innerConstant, outerConstant;
+    if (!constantValue(inner->right.get(), innerConstant) || !constantValue(outer->right.get(), outerConstant)) return false;
+
+    bool isAdditive = (outer->op == OperatorType::ADD || outer->op == OperatorType::SUB) &&
+                      (inner->op == OperatorType::ADD || inner->op == OperatorType::SUB);
+    bool isMultiplicative = outer->op == OperatorType::MULT && inner->op == OperatorType::MULT;
+    if (!isAdditive && !isMultiplicative) return false;
+
+    ASTNode::DataType type = outer->resolvedType;
+    int64_t combined;
+
+    if (isMultiplicative) {
+        evaluateOperator(OperatorType::MULT, innerConstant, outerConstant, type, combined);
+    } else {
+        int64_t lhs = innerConstant;
+        if (inner->op == OperatorType::SUB) evaluateOperator(OperatorType::SUB, 0, innerConstant, type, lhs);
+
+        evaluateOperator(outer->op, lhs, outerConstant, type, combined);
+        outer->op = OperatorType::ADD;
+    }
+
+    ExpressionSlot operand = std::move(inner->left);
+    outer->left = std::move(operand);
+    outer->right = makeConstant(combined, type, *outer->right);
+    return true;
+}
+
+} // namespace
+
+const std::vector<RewriteRule>& AlgebraicSimplifier::rules() {
+    static const std::vector<RewriteRule> table = {
+        {"canonicalize-operands", canonicalizeOperands},
+        {"add-zero",              addZero},
+        {"multiply-one",          multiplyOne},
+        {"multiply-zero",         multiplyZero},
+        {"shift-zero",            shiftZero},
+        {"subtract-self",         subtractSelf},
+        {"compare-self",          compareSelf},
+        {"reassociate-constants", reassociateConstants},
+    };
+
+    return table;
+}
+
+AlgebraicSimplifier::AlgebraicSimplifier(const std::vector<std::string>& enabledRules) :
+    m_isRuleEnabled(rules().size(), enabledRules.empty()),
+    m_rewriteCounts(rules().size(), 0)
+{
+    for (const auto& name : enabledRules) {
+        for (size_t i = 0; i < rules().size(); ++i) {
+            if (name == rules()[i].name) m_isRuleEnabled[i] = true;
+        }
+    }
+}
+
+void AlgebraicSimplifier::simplify(ASTNode& root) {
+    markInitializedReads(root);
+    traverse(root);
+}
+
+size_t AlgebraicSimplifier::rewriteCount() const {
+    size_t total = 0;
+    for (size_t count : m_rewriteCounts) total += count;
+    return total;
+}
+
+size_t AlgebraicSimplifier::rewriteCount(const std::string& ruleName) const {
+    for (size_t i = 0; i < rules().size(); ++i) {
+        if (ruleName == rules()[i].name) return m_rewriteCounts[i];
+    }
+
+    return 0;
+}
+
+// Operands are simplified before the operations using them
+void AlgebraicSimplifier::postVisit(ASTNode& node) {
+    forEachExpressionSlot(node, [this](ExpressionSlot& slot) {
+        simplifySlot(slot);
+    });
+}
+
+void AlgebraicSimplifier::simplifySlot(ExpressionSlot& slot) {
+    // Every rule either shrinks the tree or moves a constant to the right, so this terminates
+    bool isChanged = true;
+
+    while (isChanged) {
+        isChanged = false;
+        std::string before = Remarks::isEnabled() ? expressionText(slot.get()) : "";
+
+        for (size_t i = 0; i < rules().size() && !isChanged; ++i) {
+            if (m_isRuleEnabled[i] && rules()[i].apply(slot)) {
+                ++m_rewriteCounts[i];
+                isChanged = true;
+
+                if (Remarks::isEnabled()) {
+                    Remarks::applied(*slot, std::format("{}: rewrote `{}` to `{}`", rules()[i].name, before, expressionText(slot.get())));
+                }
+            }
+        }
+    }
+}
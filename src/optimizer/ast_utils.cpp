@@ -0,0 +1,766 @@
+#include "ast_utils.hpp"
+#include "arithmetic.hpp"
+#include "traversal.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+void forEachExpressionSlot(ASTNode& node, const std::function<void(ExpressionSlot&)>& callback) {
+    if (auto binary = dynamic_cast<BinaryOpNode*>(&node)) {
+        callback(binary->left);
+        callback(binary->right);
+    } else if (auto element = dynamic_cast<ArrayIndexNode*>(&node)) {
+        callback(element->indexExpression);
+    } else if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+        callback(assignment->left);
+        callback(assignment->right);
+    } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        if (forNode->condition) callback(forNode->condition);
+    } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+        if (varDecl->initExpression) callback(varDecl->initExpression);
+    } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+        if (arrayDecl->sizeExpression) callback(arrayDecl->sizeExpression);
+
+        for (auto& expression : arrayDecl->braceListInit) {
+            callback(expression);
+        }
+    }
+}
+
+std::unique_ptr<ConstantNode> makeConstant(int64_t value, ASTNode::DataType type, const ASTNode& origin) {
+    auto constant = std::make_unique<ConstantNode>(origin.m_line, origin.m_column);
+    constant->resolvedType = type;
+
+    // A char constant holds the character itself
+    if (type == ASTNode::DataType::CHAR) {
+        constant->type = ASTNode::ConstantType::CHAR_LITERAL;
+        constant->value = std::string(1, static_cast<char>(value));
+    } else {
+        constant->type = ASTNode::ConstantType::INT_10;
+        constant->value = std::to_string(value);
+    }
+
+    return constant;
+}
+
+std::unique_ptr<IdentifierNode> makeIdentifier(Symbol* symbol, const std::string& name, const ASTNode& origin) {
+    auto identifier = std::make_unique<IdentifierNode>(origin.m_line, origin.m_column, name);
+    identifier->symbolPtr = symbol;
+    identifier->resolvedType = symbol->isArray ? ASTNode::DataType::ARRAY : symbol->type;
+    return identifier;
+}
+
+std::unique_ptr<BinaryOpNode> makeBinary(
+    ASTNode::OperatorType op, ExpressionSlot left, ExpressionSlot right, ASTNode::DataType type, const ASTNode& origin
+) {
+    auto binary = std::make_unique<BinaryOpNode>(origin.m_line, origin.m_column);
+    binary->op = op;
+    binary->left = std::move(left);
+    binary->right = std::move(right);
+    binary->resolvedType = type;
+    return binary;
+}
+
+std::unique_ptr<AssignmentNode> makeAssignment(ExpressionSlot target, ExpressionSlot value, const ASTNode& origin) {
+    auto assignment = std::make_unique<AssignmentNode>(origin.m_line, origin.m_column);
+    assignment->left = std::move(target);
+    assignment->right = std::move(value);
+    return assignment;
+}
+
+std::unique_ptr<VariableDeclNode> declareTemporary(
+    SymbolTable& symbolTable, const std::string& prefix, ASTNode::DataType type, ExpressionSlot init, const ASTNode& origin
+) {
+    std::string name = prefix + "." + std::to_string(symbolTable.temporaryCount());
+    auto declaration = std::make_unique<VariableDeclNode>(origin.m_line, origin.m_column);
+
+    Symbol newSymbol;
+    newSymbol.type = type;
+    newSymbol.declarationNode = declaration.get();
+    Symbol* symbol = symbolTable.createTemporary(std::move(newSymbol));
+
+    declaration->type = type;
+    declaration->identifier = makeIdentifier(symbol, name, origin);
+    declaration->initExpression = std::move(init);
+    return declaration;
+}
+
+namespace {
+
+// Appends the text of `node`, stopping once the text reaches `limit` characters
+void appendText(const ExpressionNode* node, std::string& text, size_t limit) {
+    if (text.size() >= limit) return;
+
+    if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+        text += identifier->name;
+    } else if (auto element = dynamic_cast<const ArrayIndexNode*>(node)) {
+        text += element->identifier->name + "[";
+        appendText(element->indexExpression.get(), text, limit);
+        text += "]";
+    } else if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        auto appendOperand = [&text, limit](const ExpressionNode* operand) {
+            bool isNested = dynamic_cast<const BinaryOpNode*>(operand);
+            if (isNested) text += "(";
+            appendText(operand, text, limit);
+            if (isNested) text += ")";
+        };
+
+        // The division prints as a backslash in the tree dump
+        appendOperand(binary->left.get());
+        text += " " + (binary->op == ASTNode::OperatorType::DIV ? "/" : ASTNode::operatorToString(binary->op)) + " ";
+        appendOperand(binary->right.get());
+    } else if (auto constant = dynamic_cast<const ConstantNode*>(node)) {
+        int64_t value;
+
+        if (!constantValue(constant, value)) {
+            text += "\"" + constant->value + "\"";
+        } else if (constant->type == ASTNode::ConstantType::CHAR_LITERAL && value >= 0x20 && value < 0x7f) {
+            text += "'" + constant->value + "'";
+        } else {
+            text += std::to_string(value);
+        }
+    }
+}
+
+} // namespace
+
+std::string expressionText(const ExpressionNode* node) {
+    constexpr size_t LIMIT = 64;
+
+    std::string text;
+    appendText(node, text, LIMIT);
+
+    if (text.size() > LIMIT) {
+        text.resize(LIMIT);
+        text += "...";
+    }
+
+    return text;
+}
+
+ExpressionSlot cloneExpression(const ExpressionNode* node) {
+    if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+        auto copy = makeIdentifier(identifier->symbolPtr, identifier->name, *identifier);
+        copy->resolvedType = identifier->resolvedType;
+        return copy;
+    }
+
+    if (auto constant = dynamic_cast<const ConstantNode*>(node)) {
+        auto copy = std::make_unique<ConstantNode>(constant->m_line, constant->m_column);
+        copy->value = constant->value;
+        copy->type = constant->type;
+        copy->resolvedType = constant->resolvedType;
+        return copy;
+    }
+
+    if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        auto copy = makeBinary(
+            binary->op, cloneExpression(binary->left.get()), cloneExpression(binary->right.get()),
+            binary->resolvedType, *binary
+        );
+        copy->divisionPlan = binary->divisionPlan;
+        return copy;
+    }
+
+    if (auto element = dynamic_cast<const ArrayIndexNode*>(node)) {
+        auto copy = std::make_unique<ArrayIndexNode>(element->m_line, element->m_column);
+        copy->identifier = std::unique_ptr<IdentifierNode>(
+            static_cast<IdentifierNode*>(cloneExpression(element->identifier.get()).release())
+        );
+        copy->indexExpression = cloneExpression(element->indexExpression.get());
+        copy->resolvedType = element->resolvedType;
+        return copy;
+    }
+
+    return nullptr;
+}
+
+std::unique_ptr<StatementNode> cloneStatement(const StatementNode* node) {
+    if (auto assignment = dynamic_cast<const AssignmentNode*>(node)) {
+        return makeAssignment(cloneExpression(assignment->left.get()), cloneExpression(assignment->right.get()), *assignment);
+    }
+
+    if (auto empty = dynamic_cast<const EmptyStatementNode*>(node)) {
+        auto copy = std::make_unique<EmptyStatementNode>(empty->m_line, empty->m_column);
+        copy->trace = empty->trace;
+        return copy;
+    }
+
+    if (auto compound = dynamic_cast<const CompoundStatementNode*>(node)) {
+        auto copy = std::make_unique<CompoundStatementNode>();
+        for (const auto& statement : compound->statements) {
+            auto statementCopy = cloneStatement(statement.get());
+            if (!statementCopy) return nullptr;
+            copy->statements.push_back(std::move(statementCopy));
+        }
+        return copy;
+    }
+
+    if (auto loop = dynamic_cast<const ForNode*>(node)) {
+        auto copy = std::make_unique<ForNode>(loop->m_line, loop->m_column);
+        copy->body = cloneStatement(loop->body.get());
+        if (!copy->body) return nullptr;
+
+        if (loop->init) {
+            copy->init.reset(static_cast<AssignmentNode*>(cloneStatement(loop->init.get()).release()));
+        }
+        if (loop->increment) {
+            copy->increment.reset(static_cast<AssignmentNode*>(cloneStatement(loop->increment.get()).release()));
+        }
+        if (loop->condition) copy->condition = cloneExpression(loop->condition.get());
+        return copy;
+    }
+
+    if (auto varDecl = dynamic_cast<const VariableDeclNode*>(node)) {
+        auto copy = std::make_unique<VariableDeclNode>(varDecl->m_line, varDecl->m_column);
+        copy->type = varDecl->type;
+        copy->identifier.reset(static_cast<IdentifierNode*>(cloneExpression(varDecl->identifier.get()).release()));
+        if (const IdentifierNode *name = varDecl->typedefName.get()) {
+            // Type names have no value, only the name is kept
+            copy->typedefName = std::make_unique<IdentifierNode>(name->m_line, name->m_column, name->name);
+            copy->typedefName->symbolPtr = name->symbolPtr;
+            copy->typedefName->resolvedType = name->resolvedType;
+        }
+        if (varDecl->initExpression) copy->initExpression = cloneExpression(varDecl->initExpression.get());
+        return copy;
+    }
+
+    return nullptr;
+}
+
+namespace {
+
+class WrittenSymbolCollector : public Traversal {
+public:
+    explicit WrittenSymbolCollector(std::unordered_set<Symbol*>& written) : m_written(written) {}
+
+    void collect(ASTNode& node) { traverse(node); }
+
+private:
+    bool preVisit(ASTNode& node) override {
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            if (auto identifier = dynamic_cast<IdentifierNode*>(assignment->left.get())) {
+                m_written.insert(identifier->symbolPtr);
+            } else if (auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get())) {
+                m_written.insert(element->identifier->symbolPtr);
+            }
+        } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+            declare(varDecl->identifier->symbolPtr);
+        } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+            declare(arrayDecl->identifier->symbolPtr);
+        }
+
+        // Expressions have no side effects
+        return !dynamic_cast<ExpressionNode*>(&node);
+    }
+
+    // An array declaration also initializes its promoted elements
+    void declare(Symbol* symbol) {
+        m_written.insert(symbol);
+        m_written.insert(symbol->details().promotedElements.begin(), symbol->details().promotedElements.end());
+    }
+
+    std::unordered_set<Symbol*>& m_written;
+};
+
+} // namespace
+
+void collectWrittenSymbols(ASTNode& node, std::unordered_set<Symbol*>& written) {
+    WrittenSymbolCollector(written).collect(node);
+}
+
+namespace {
+
+// True for an access whose index is a constant within the bounds of the array
+bool isConstantElement(const ArrayIndexNode& element) {
+    int64_t index;
+    if (!constantValue(element.indexExpression.get(), index)) return false;
+    return index >= 0 && index < element.identifier->symbolPtr->arraySize;
+}
+
+} // namespace
+
+bool matchCountedLoop(ForNode& loop, CountedLoop& counted) {
+    if (!loop.condition || !loop.increment) return false;
+
+    ExpressionNode *variable = loop.increment->left.get();
+    Symbol *symbol;
+
+    if (auto identifier = dynamic_cast<IdentifierNode*>(variable)) {
+        symbol = identifier->symbolPtr;
+        if (symbol->isArray) return false;
+    } else if (auto element = dynamic_cast<ArrayIndexNode*>(variable); element && isConstantElement(*element)) {
+        symbol = element->identifier->symbolPtr;
+    } else {
+        return false;
+    }
+
+    // v = v + c or v = v - c
+    auto update = dynamic_cast<BinaryOpNode*>(loop.increment->right.get());
+    int64_t step;
+
+    if (!update || !isSameExpression(update->left.get(), variable) || !constantValue(update->right.get(), step)) return false;
+    if (update->op != ASTNode::OperatorType::ADD && update->op != ASTNode::OperatorType::SUB) return false;
+    if (step == 0 || step == INT64_MIN) return false;
+    if (update->op == ASTNode::OperatorType::SUB) step = -step;
+
+    // v < N, v <= N, v > N or v >= N
+    auto condition = dynamic_cast<BinaryOpNode*>(loop.condition.get());
+    int64_t limit, last;
+
+    if (!condition || !isSameExpression(condition->left.get(), variable) || !constantValue(condition->right.get(), limit)) {
+        return false;
+    }
+
+    int64_t max = INT64_MAX;
+    switch (symbol->type) {
+        case ASTNode::DataType::CHAR:  max = INT8_MAX; break;
+        case ASTNode::DataType::SHORT: max = INT16_MAX; break;
+        case ASTNode::DataType::INT:   max = INT32_MAX; break;
+        default: break;
+    }
+
+    if (step > 0) {
+        if (condition->op == ASTNode::OperatorType::LT && limit != INT64_MIN) last = limit - 1;
+        else if (condition->op == ASTNode::OperatorType::LE) last = limit;
+        else return false;
+
+        if (last > max - step) return false;
+    } else {
+        if (condition->op == ASTNode::OperatorType::GT && limit != INT64_MAX) last = limit + 1;
+        else if (condition->op == ASTNode::OperatorType::GE) last = limit;
+        else return false;
+
+        if (last < -max - 1 - step) return false;
+    }
+
+    counted = CountedLoop{variable, symbol, step, last};
+    return true;
+}
+
+bool countIterations(const ForNode& loop, const CountedLoop& counted, int64_t& first, uint64_t& count) {
+    if (!loop.init || !isSameExpression(loop.init->left.get(), counted.variable)) return false;
+    if (!constantValue(loop.init->right.get(), first)) return false;
+
+    first = narrowToType(counted.symbol->type, first);
+
+    __extension__ using Int128 = __int128;
+    Int128 distance = counted.step > 0
+        ? static_cast<Int128>(counted.last) - first
+        : static_cast<Int128>(first) - counted.last;
+    Int128 stride = counted.step > 0 ? static_cast<Int128>(counted.step) : -static_cast<Int128>(counted.step);
+
+    count = distance < 0 ? 0 : static_cast<uint64_t>(distance / stride + 1);
+    return true;
+}
+
+bool runsAtLeastOnce(ForNode& loop) {
+    CountedLoop counted;
+    int64_t first;
+    uint64_t count;
+
+    return matchCountedLoop(loop, counted) && countIterations(loop, counted, first, count) && count > 0;
+}
+
+bool loopRange(const ForNode& loop, const CountedLoop& counted, LoopRange& range) {
+    int64_t first;
+    uint64_t count;
+    if (!countIterations(loop, counted, first, count) || count == 0) return false;
+
+    int64_t last = static_cast<int64_t>(static_cast<uint64_t>(first) + (count - 1) * static_cast<uint64_t>(counted.step));
+    range = LoopRange{std::min(first, last), std::max(first, last)};
+    return true;
+}
+
+bool matchAffine(
+    const ExpressionNode* root, const ExpressionNode* variable, int64_t& coefficient, int64_t& constant, const LoopRange* range
+) {
+    std::vector<std::pair<const ExpressionNode*, bool>> nodes{{root, false}};
+    std::vector<std::pair<int64_t, int64_t>> values;
+
+    while (!nodes.empty()) {
+        auto [node, isExpanded] = nodes.back();
+        nodes.pop_back();
+
+        auto binary = dynamic_cast<const BinaryOpNode*>(node);
+        int64_t value;
+
+        if (binary && !isExpanded) {
+            nodes.emplace_back(node, true);
+            nodes.emplace_back(binary->right.get(), false);
+            nodes.emplace_back(binary->left.get(), false);
+        } else if (binary) {
+            auto [rc, rd] = values.back();
+            values.pop_back();
+            auto& [lc, ld] = values.back();
+            bool isOverflow = false;
+
+            switch (binary->op) {
+                case ASTNode::OperatorType::ADD:
+                    isOverflow = __builtin_add_overflow(lc, rc, &lc) || __builtin_add_overflow(ld, rd, &ld);
+                    break;
+                case ASTNode::OperatorType::SUB:
+                    isOverflow = __builtin_sub_overflow(lc, rc, &lc) || __builtin_sub_overflow(ld, rd, &ld);
+                    break;
+                case ASTNode::OperatorType::MULT:
+                    // One of the factors must be a constant
+                    if (lc != 0 && rc != 0) return false;
+                    isOverflow = lc != 0
+                        ? __builtin_mul_overflow(lc, rd, &lc) || __builtin_mul_overflow(ld, rd, &ld)
+                        : __builtin_mul_overflow(ld, rc, &lc) || __builtin_mul_overflow(ld, rd, &ld);
+                    break;
+                default:
+                    return false;
+            }
+
+            if (isOverflow) return false;
+            if (!range) continue;
+
+            // An affine value is monotonic, so it's enough to check the ends of the range
+            for (int64_t v : {range->first, range->last}) {
+                int64_t value;
+                if (__builtin_mul_overflow(lc, v, &value) || __builtin_add_overflow(value, ld, &value)) return false;
+                if (narrowToType(binary->resolvedType, value) != value) return false;
+            }
+        } else if (isSameExpression(node, variable)) {
+            values.emplace_back(1, 0);
+        } else if (constantValue(node, value)) {
+            values.emplace_back(0, value);
+        } else {
+            return false;
+        }
+    }
+
+    coefficient = values.back().first;
+    constant = values.back().second;
+    return true;
+}
+
+namespace {
+
+// Walks the statements in the order the Interpreter runs them, tracking what
+// is initialized on every path to the current node
+class InitializationMarker : public Traversal {
+public:
+    void mark(ASTNode& root) { traverse(root); }
+
+private:
+    // Elements low..high of the array
+    struct Fill {
+        const Symbol *array;
+        int64_t low;
+        int64_t high;
+    };
+
+    struct State {
+        std::unordered_set<const Symbol*> scalars; // Includes promoted elements
+        std::vector<Fill> fills;                   // Disjoint and not adjacent
+    };
+
+    // Loop whose body is being walked; `node` is null unless its variable ranges over low..high
+    struct Loop {
+        ForNode *node;
+        CountedLoop counted;
+        int64_t low;
+        int64_t high;
+    };
+
+    ASTNode* nextChild(ASTNode& node, size_t& step) override {
+        // The value is evaluated before the index of the target, and the target isn't read
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            switch (step++) {
+                case 0: return assignment->right.get();
+                case 1:
+                    if (auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get())) {
+                        return element->indexExpression.get();
+                    }
+                    return nullptr;
+                default: return nullptr;
+            }
+        }
+
+        if (auto element = dynamic_cast<ArrayIndexNode*>(&node)) {
+            return step++ == 0 ? element->indexExpression.get() : nullptr;
+        }
+
+        // The body and the increment run after the condition, and only if it holds
+        if (auto loop = dynamic_cast<ForNode*>(&node)) {
+            switch (step++) {
+                case 0: if (loop->init) return loop->init.get(); [[fallthrough]];
+                case 1: step = 2; if (loop->condition) return loop->condition.get(); [[fallthrough]];
+                case 2:
+                    step = 3;
+                    m_entryStates.push_back(m_state);
+                    enterLoop(*loop);
+                    return loop->body.get();
+                case 3: return loop->increment.get();
+                default: return nullptr;
+            }
+        }
+
+        return Traversal::nextChild(node, step);
+    }
+
+    void postVisit(ASTNode& node) override {
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            if (auto identifier = dynamic_cast<IdentifierNode*>(assignment->left.get())) {
+                identifier->isInitialized = true;
+                m_state.scalars.insert(identifier->symbolPtr);
+            } else if (auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get())) {
+                int64_t index;
+                element->isInitialized = true;
+                if (constantValue(element->indexExpression.get(), index)) fill(element->identifier->symbolPtr, index, index);
+            }
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(&node)) {
+            identifier->isInitialized = m_state.scalars.count(identifier->symbolPtr) > 0;
+        } else if (auto element = dynamic_cast<ArrayIndexNode*>(&node)) {
+            int64_t low, high;
+            element->isInitialized = subscriptRange(element->indexExpression.get(), low, high)
+                && isFilled(element->identifier->symbolPtr, low, high);
+        } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+            // Declarations run again with every iteration of a loop around them
+            Symbol *symbol = varDecl->identifier->symbolPtr;
+            varDecl->identifier->isInitialized = true;
+
+            if (symbol->isArray) {
+                forgetArray(symbol);
+            } else if (varDecl->initExpression) {
+                m_state.scalars.insert(symbol);
+            } else {
+                m_state.scalars.erase(symbol);
+            }
+        } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+            // An initializer fills the whole array, promoted elements included
+            Symbol *symbol = arrayDecl->identifier->symbolPtr;
+            forgetArray(symbol);
+
+            if (arrayDecl->initializerImage) {
+                fill(symbol, 0, symbol->arraySize - 1);
+                m_state.scalars.insert(symbol->details().promotedElements.begin(), symbol->details().promotedElements.end());
+            }
+        } else if (auto loop = dynamic_cast<ForNode*>(&node)) {
+            // A loop which may not run leaves only what was initialized before its body
+            if (runsAtLeastOnce(*loop)) {
+                fillFromBody();
+            } else {
+                m_state = std::move(m_entryStates.back());
+            }
+
+            m_entryStates.pop_back();
+            m_loops.pop_back();
+        }
+    }
+
+    // The variable of a counted loop takes the values of its range in the body,
+    // as long as the body doesn't store to it
+    void enterLoop(ForNode& node) {
+        Loop loop{&node, {}, 0, 0};
+        int64_t first;
+        uint64_t count;
+
+        if (matchCountedLoop(node, loop.counted) && countIterations(node, loop.counted, first, count) && count > 0
+            && dynamic_cast<IdentifierNode*>(loop.counted.variable)) {
+            std::unordered_set<Symbol*> written;
+            collectWrittenSymbols(*node.body, written);
+
+            if (!written.count(loop.counted.symbol)) {
+                loop.low = std::min(first, loop.counted.last);
+                loop.high = std::max(first, loop.counted.last);
+                m_loops.push_back(loop);
+                return;
+            }
+        }
+
+        m_loops.push_back(Loop{nullptr, {}, 0, 0});
+    }
+
+    // Values of a constant subscript, or of `v`, `v + c`, `v - c` or `c + v` for
+    // the variable `v` of a counted loop around the access
+    bool subscriptRange(const ExpressionNode* index, int64_t& low, int64_t& high) const {
+        if (constantValue(index, low)) {
+            high = low;
+            return true;
+        }
+
+        auto binary = dynamic_cast<const BinaryOpNode*>(index);
+        const ExpressionNode *variable = index;
+        int64_t offset = 0;
+
+        if (binary && binary->op == ASTNode::OperatorType::ADD && constantValue(binary->left.get(), offset)) {
+            variable = binary->right.get();
+        } else if (binary && binary->op == ASTNode::OperatorType::ADD && constantValue(binary->right.get(), offset)) {
+            variable = binary->left.get();
+        } else if (binary && binary->op == ASTNode::OperatorType::SUB && constantValue(binary->right.get(), offset)) {
+            if (offset == INT64_MIN) return false;
+            offset = -offset;
+            variable = binary->left.get();
+        } else if (binary) {
+            return false;
+        }
+
+        auto identifier = dynamic_cast<const IdentifierNode*>(variable);
+        if (identifier == nullptr) return false;
+
+        auto loop = std::find_if(m_loops.rbegin(), m_loops.rend(), [identifier](const Loop& loop) {
+            return loop.node && loop.counted.symbol == identifier->symbolPtr;
+        });
+        if (loop == m_loops.rend()) return false;
+
+        if (__builtin_add_overflow(loop->low, offset, &low) || __builtin_add_overflow(loop->high, offset, &high)) return false;
+
+        // The operation is evaluated in its type
+        return !binary || (narrowToType(binary->resolvedType, low) == low && narrowToType(binary->resolvedType, high) == high);
+    }
+
+    // A counted loop stepping by one stores to every element its subscript ranges over
+    void fillFromBody() {
+        const Loop& loop = m_loops.back();
+        if (loop.node == nullptr || (loop.counted.step != 1 && loop.counted.step != -1)) return;
+
+        // Statements of nested loops may not run
+        std::vector<StatementNode*> pending{loop.node->body.get()};
+
+        while (!pending.empty()) {
+            StatementNode *statement = pending.back();
+            pending.pop_back();
+
+            if (auto compound = dynamic_cast<CompoundStatementNode*>(statement)) {
+                for (auto& nested : compound->statements) pending.push_back(nested.get());
+            } else if (auto assignment = dynamic_cast<AssignmentNode*>(statement)) {
+                auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get());
+                int64_t low, high;
+
+                if (element && subscriptRange(element->indexExpression.get(), low, high)) {
+                    fill(element->identifier->symbolPtr, low, high);
+                }
+            }
+        }
+    }
+
+    bool isFilled(const Symbol* array, int64_t low, int64_t high) const {
+        return std::any_of(m_state.fills.begin(), m_state.fills.end(), [=](const Fill& fill) {
+            return fill.array == array && fill.low <= low && high <= fill.high;
+        });
+    }
+
+    // Merges the elements with the overlapping and adjacent ranges. A store out
+    // of bounds raises an error, so only the elements within count
+    void fill(const Symbol* array, int64_t low, int64_t high) {
+        low = std::max<int64_t>(low, 0);
+        high = std::min<int64_t>(high, array->arraySize - 1);
+        if (low > high) return;
+
+        std::erase_if(m_state.fills, [&](const Fill& fill) {
+            if (fill.array != array || fill.high < low - 1 || fill.low > high + 1) return false;
+
+            low = std::min(low, fill.low);
+            high = std::max(high, fill.high);
+            return true;
+        });
+
+        m_state.fills.push_back(Fill{array, low, high});
+    }
+
+    void forgetArray(const Symbol* array) {
+        std::erase_if(m_state.fills, [array](const Fill& fill) { return fill.array == array; });
+        for (const Symbol *element : array->details().promotedElements) m_state.scalars.erase(element);
+    }
+
+    State m_state;
+    std::vector<State> m_entryStates;
+    std::vector<Loop> m_loops;
+};
+
+} // namespace
+
+void markInitializedReads(ASTNode& root) {
+    InitializationMarker().mark(root);
+}
+
+bool isSameExpression(const ExpressionNode* lhs, const ExpressionNode* rhs) {
+    // Pairs still to compare; kept on the heap so that long chains don't recurse
+    std::vector<std::pair<const ExpressionNode*, const ExpressionNode*>> pending{{lhs, rhs}};
+
+    while (!pending.empty()) {
+        auto [a, b] = pending.back();
+        pending.pop_back();
+
+        if (a == nullptr || b == nullptr) {
+            if (a != b) return false;
+            continue;
+        }
+
+        if (a->resolvedType != b->resolvedType) return false;
+
+        if (auto left = dynamic_cast<const IdentifierNode*>(a)) {
+            auto right = dynamic_cast<const IdentifierNode*>(b);
+            if (!right || left->symbolPtr != right->symbolPtr) return false;
+        } else if (dynamic_cast<const ConstantNode*>(a)) {
+            int64_t left, right;
+            if (!constantValue(a, left) || !constantValue(b, right) || left != right) return false;
+        } else if (auto left = dynamic_cast<const BinaryOpNode*>(a)) {
+            auto right = dynamic_cast<const BinaryOpNode*>(b);
+            if (!right || left->op != right->op) return false;
+            pending.emplace_back(left->left.get(), right->left.get());
+            pending.emplace_back(left->right.get(), right->right.get());
+        } else if (auto left = dynamic_cast<const ArrayIndexNode*>(a)) {
+            auto right = dynamic_cast<const ArrayIndexNode*>(b);
+            if (!right || left->identifier->symbolPtr != right->identifier->symbolPtr) return false;
+            pending.emplace_back(left->indexExpression.get(), right->indexExpression.get());
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool mayTrapItself(const ExpressionNode* node) {
+    if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+        const Symbol *symbol = identifier->symbolPtr;
+        return !symbol->isArray && !symbol->isCompilerTemporary && !identifier->isInitialized;
+    }
+
+    if (auto element = dynamic_cast<const ArrayIndexNode*>(node)) {
+        return !isConstantElement(*element) || !element->isInitialized;
+    }
+
+    int64_t amount;
+
+    auto binary = dynamic_cast<const BinaryOpNode*>(node);
+    if (binary == nullptr) return false;
+
+    bool isConstant = constantValue(binary->right.get(), amount);
+
+    switch (binary->op) {
+        case ASTNode::OperatorType::DIV:
+        case ASTNode::OperatorType::MOD:
+            return !isConstant || amount == 0;
+        case ASTNode::OperatorType::BLS:
+        case ASTNode::OperatorType::BRS:
+            return !isConstant || amount < 0 || amount > 63;
+        default:
+            return false;
+    }
+}
+
+bool mayTrap(const ExpressionNode* node) {
+    std::vector<const ExpressionNode*> pending{node};
+
+    while (!pending.empty()) {
+        const ExpressionNode* current = pending.back();
+        pending.pop_back();
+
+        if (mayTrapItself(current)) return true;
+
+        if (auto element = dynamic_cast<const ArrayIndexNode*>(current)) {
+            pending.push_back(element->indexExpression.get());
+        } else if (auto binary = dynamic_cast<const BinaryOpNode*>(current)) {
+            pending.push_back(binary->left.get());
+            pending.push_back(binary->right.get());
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,391 @@
+#include "bounds_check_eliminator.hpp"
+#include "arithmetic.hpp"
+#include "ast_utils.hpp"
+#include "remarks.hpp"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <unordered_set>
+
+__extension__ using Int128 = __int128;
+
+BoundsCheckEliminator::BoundsCheckEliminator(const std::string& filepath) :
+    m_filepath(filepath)
+{}
+
+void BoundsCheckEliminator::eliminate(ASTNode& root) {
+    m_state.clear();
+    m_storedValues.clear();
+    m_arrayDeclarations.clear();
+    traverse(root);
+}
+
+size_t BoundsCheckEliminator::eliminatedCount() const {
+    return m_eliminatedCount;
+}
+
+size_t BoundsCheckEliminator::failingCount() const {
+    return m_failingCount;
+}
+
+// Statements update the state in execution order; expressions are evaluated by the statement owning them
+bool BoundsCheckEliminator::preVisit(ASTNode& node) {
+    if (dynamic_cast<ExpressionNode*>(&node)) return false;
+
+    if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+        Interval value = evaluate(*assignment->right);
+
+        if (auto identifier = dynamic_cast<IdentifierNode*>(assignment->left.get())) {
+            assign(identifier->symbolPtr, value);
+        } else if (auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get())) {
+            checkIndex(*element, evaluate(*element->indexExpression));
+            store(element->identifier->symbolPtr, value);
+        }
+
+        return false;
+    }
+
+    if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+        Symbol *symbol = varDecl->identifier->symbolPtr;
+        forgetElements(symbol);
+
+        // A typedef-name can stand for an array type
+        if (symbol->isArray) {
+            m_storedValues.try_emplace(symbol, Interval{INT64_MAX, INT64_MIN});
+            m_arrayDeclarations.emplace_back(symbol, nullptr);
+        }
+
+        if (varDecl->initExpression) {
+            assign(symbol, evaluate(*varDecl->initExpression));
+        } else {
+            m_state.erase(symbol);
+        }
+
+        return false;
+    }
+
+    if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+        Symbol *symbol = arrayDecl->identifier->symbolPtr;
+        m_storedValues.try_emplace(symbol, Interval{INT64_MAX, INT64_MIN});
+        m_arrayDeclarations.emplace_back(symbol, arrayDecl);
+
+        for (auto& expression : arrayDecl->braceListInit) {
+            store(symbol, evaluate(*expression));
+        }
+
+        // The tail of an initialized array is zeroed
+        if (arrayDecl->initializerImage) {
+            store(symbol, Interval{0, 0});
+            for (char ch : arrayDecl->stringLiteralInit ? arrayDecl->stringLiteralInit->value : std::string()) {
+                store(symbol, Interval{ch, ch});
+            }
+        }
+
+        forgetElements(symbol);
+
+        return false;
+    }
+
+    if (auto loop = dynamic_cast<ForNode*>(&node)) {
+        enterLoop(*loop);
+    }
+
+    return true;
+}
+
+// The header of a loop is analyzed by enterLoop, only the body is left
+ASTNode* BoundsCheckEliminator::nextChild(ASTNode& node, size_t& step) {
+    if (auto loop = dynamic_cast<ForNode*>(&node)) {
+        return step++ == 0 ? loop->body.get() : nullptr;
+    }
+
+    return node.child(step++);
+}
+
+void BoundsCheckEliminator::postVisit(ASTNode& node) {
+    if (dynamic_cast<ForNode*>(&node)) {
+        m_state = std::move(m_statesAfterLoops.back());
+        m_statesAfterLoops.pop_back();
+    }
+}
+
+void BoundsCheckEliminator::enterLoop(ForNode& loop) {
+    if (loop.init) preVisit(*loop.init);
+
+    std::unordered_set<Symbol*> written, writtenInBody;
+    collectWrittenSymbols(loop, written);
+    collectWrittenSymbols(*loop.body, writtenInBody);
+
+    // Counted loop: i = i + c, with i < N or i <= N (i > N or i >= N when c is negative)
+    Symbol *variable = nullptr;
+    Interval entry{};
+    int64_t step = 0;
+
+    auto target = loop.increment ? dynamic_cast<IdentifierNode*>(loop.increment->left.get()) : nullptr;
+    auto update = loop.increment ? dynamic_cast<BinaryOpNode*>(loop.increment->right.get()) : nullptr;
+    auto condition = dynamic_cast<BinaryOpNode*>(loop.condition.get());
+
+    if (target && update && condition && !writtenInBody.count(target->symbolPtr) &&
+        (update->op == ASTNode::OperatorType::ADD || update->op == ASTNode::OperatorType::SUB) &&
+        constantValue(update->right.get(), step) && step != 0 && step != INT64_MIN)
+    {
+        auto counter = dynamic_cast<IdentifierNode*>(update->left.get());
+        auto compared = dynamic_cast<IdentifierNode*>(condition->left.get());
+
+        if (counter && compared && counter->symbolPtr == target->symbolPtr && compared->symbolPtr == target->symbolPtr) {
+            variable = target->symbolPtr;
+            entry = rangeOf(variable);
+            if (update->op == ASTNode::OperatorType::SUB) step = -step;
+        }
+    }
+
+    // The state at the head of the loop: whatever the loop writes is unknown
+    for (Symbol* symbol : written) {
+        m_state.erase(symbol);
+    }
+
+    m_statesAfterLoops.push_back(m_state);
+
+    if (variable) {
+        Interval limit = evaluate(*condition->right);
+        Interval type = typeRange(variable->type);
+        Interval body = type;
+        bool isBounded = false;
+
+        // The value after the last increment mustn't wrap around
+        if (step > 0 && (condition->op == ASTNode::OperatorType::LT || condition->op == ASTNode::OperatorType::LE)) {
+            Int128 last = static_cast<Int128>(limit.hi) - (condition->op == ASTNode::OperatorType::LT ? 1 : 0);
+            last = std::min<Int128>(last, type.hi);
+            isBounded = last + step <= type.hi && entry.lo <= last;
+            body = Interval{entry.lo, static_cast<int64_t>(last)};
+        } else if (step < 0 && (condition->op == ASTNode::OperatorType::GT || condition->op == ASTNode::OperatorType::GE)) {
+            Int128 last = static_cast<Int128>(limit.lo) + (condition->op == ASTNode::OperatorType::GT ? 1 : 0);
+            last = std::max<Int128>(last, type.lo);
+            isBounded = last + step >= type.lo && entry.hi >= last;
+            body = Interval{static_cast<int64_t>(last), entry.hi};
+        }
+
+        if (isBounded) m_state[variable] = body;
+    } else {
+        if (loop.condition) evaluate(*loop.condition);
+        if (loop.increment) preVisit(*loop.increment);
+    }
+
+    // Only the body is analyzed from here; the increment may have narrowed its target
+    for (Symbol* symbol : written) {
+        if (symbol != variable) m_state.erase(symbol);
+    }
+}
+
+void BoundsCheckEliminator::assign(const Symbol* symbol, Interval value) {
+    Interval type = typeRange(symbol->type);
+
+    // A value which doesn't fit wraps around when it's stored
+    if (value.lo >= type.lo && value.hi <= type.hi) {
+        m_state[symbol] = value;
+    } else {
+        m_state.erase(symbol);
+    }
+}
+
+// A value which doesn't fit the array wraps around to anything of its type
+void BoundsCheckEliminator::store(Symbol* array, Interval value) {
+    Interval type = typeRange(array->type);
+    if (value.lo < type.lo || value.hi > type.hi) value = type;
+
+    Interval& stored = m_storedValues.try_emplace(array, Interval{INT64_MAX, INT64_MIN}).first->second;
+    stored = Interval{std::min(stored.lo, value.lo), std::max(stored.hi, value.hi)};
+}
+
+size_t BoundsCheckEliminator::narrowArrays() {
+    size_t count = 0;
+
+    for (auto& [array, stored] : m_storedValues) {
+        for (ASTNode::DataType type : {ASTNode::DataType::CHAR, ASTNode::DataType::SHORT, ASTNode::DataType::INT}) {
+            Interval range = typeRange(type);
+            if (typeSize(type) >= typeSize(array->type) || stored.lo < range.lo || stored.hi > range.hi) continue;
+
+            array->editDetails().storageType = type;
+            ++count;
+            break;
+        }
+    }
+
+    // The images of the initializers are packed in the storage type as well
+    for (auto [array, declaration] : m_arrayDeclarations) {
+        if (array->details().storageType == ASTNode::DataType::UNKNOWN || !declaration) continue;
+
+        if (Remarks::isEnabled()) {
+            const Interval& stored = m_storedValues.at(array);
+            Remarks::applied(*declaration, std::format(
+                "stored `{}` as {}[], its values are in [{}, {}]",
+                declaration->identifier->name, ASTNode::typeToString(array->details().storageType), stored.lo, stored.hi
+            ));
+        }
+
+        if (!declaration->initializerImage) continue;
+
+        InitializerImage& image = *declaration->initializerImage;
+        size_t width = typeSize(array->details().storageType);
+        image.packed.assign(image.values.size() * width, 0);
+
+        for (size_t i = 0; i < image.values.size(); ++i) {
+            int64_t value = std::visit([](auto v) -> int64_t {
+                if constexpr (std::is_same_v<decltype(v), std::monostate>) return 0;
+                else return v;
+            }, image.values[i]);
+            packValue(array->details().storageType, value, &image.packed[i * width]);
+        }
+    }
+
+    return count;
+}
+
+// The promoted elements of an array are reset by its declaration
+void BoundsCheckEliminator::forgetElements(const Symbol* array) {
+    for (const Symbol* element : array->details().promotedElements) {
+        m_state.erase(element);
+    }
+}
+
+BoundsCheckEliminator::Interval BoundsCheckEliminator::evaluate(ExpressionNode& root) {
+    std::vector<std::pair<ExpressionNode*, bool>> nodes{{&root, false}};
+    std::vector<Interval> values;
+
+    while (!nodes.empty()) {
+        auto [node, isExpanded] = nodes.back();
+        nodes.pop_back();
+
+        auto binary = dynamic_cast<BinaryOpNode*>(node);
+        auto element = dynamic_cast<ArrayIndexNode*>(node);
+
+        if (binary && !isExpanded) {
+            nodes.emplace_back(node, true);
+            nodes.emplace_back(binary->right.get(), false);
+            nodes.emplace_back(binary->left.get(), false);
+        } else if (element && !isExpanded) {
+            nodes.emplace_back(node, true);
+            nodes.emplace_back(element->indexExpression.get(), false);
+        } else if (binary) {
+            Interval rhs = values.back();
+            values.pop_back();
+            Interval lhs = values.back();
+            values.back() = evaluateOperator(binary->op, lhs, rhs, binary->resolvedType);
+        } else if (element) {
+            checkIndex(*element, values.back());
+            values.back() = typeRange(element->resolvedType);
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+            values.push_back(rangeOf(identifier->symbolPtr));
+        } else {
+            int64_t value;
+            values.push_back(constantValue(node, value) ? Interval{value, value} : typeRange(node->resolvedType));
+        }
+    }
+
+    return values.back();
+}
+
+// Bounds of `lhs op rhs`, unknown when the operation may wrap around or trap
+BoundsCheckEliminator::Interval BoundsCheckEliminator::evaluateOperator(
+    ASTNode::OperatorType op, Interval lhs, Interval rhs, ASTNode::DataType type
+) const {
+    Interval result = typeRange(type);
+    Int128 lo, hi;
+
+    // The operations below are monotonic in each operand, so the bounds are reached at the corners
+    auto corners = [&](auto apply) {
+        Int128 values[] = {apply(lhs.lo, rhs.lo), apply(lhs.lo, rhs.hi), apply(lhs.hi, rhs.lo), apply(lhs.hi, rhs.hi)};
+        lo = *std::min_element(std::begin(values), std::end(values));
+        hi = *std::max_element(std::begin(values), std::end(values));
+    };
+
+    bool isDivisorNonZero = rhs.lo > 0 || rhs.hi < 0;
+    bool isShiftInRange = rhs.lo >= 0 && rhs.hi <= 63;
+
+    switch (op) {
+        case ASTNode::OperatorType::ADD:
+            corners([](Int128 l, Int128 r) { return l + r; });
+            break;
+        case ASTNode::OperatorType::SUB:
+            corners([](Int128 l, Int128 r) { return l - r; });
+            break;
+        case ASTNode::OperatorType::MULT:
+            corners([](Int128 l, Int128 r) { return l * r; });
+            break;
+        case ASTNode::OperatorType::DIV:
+            if (!isDivisorNonZero) return result;
+            corners([](Int128 l, Int128 r) { return l / r; });
+            break;
+        case ASTNode::OperatorType::MOD: {
+            if (!isDivisorNonZero) return result;
+
+            // The remainder is smaller than the divisor and has the sign of the dividend
+            Int128 lowest = rhs.lo, highest = rhs.hi;
+            Int128 bound = std::max(lowest < 0 ? -lowest : lowest, highest < 0 ? -highest : highest) - 1;
+            lo = lhs.lo < 0 ? std::max<Int128>(lhs.lo, -bound) : 0;
+            hi = lhs.hi > 0 ? std::min<Int128>(lhs.hi, bound) : 0;
+            break;
+        }
+        case ASTNode::OperatorType::BLS:
+            if (!isShiftInRange) return result;
+            corners([](Int128 l, Int128 r) { return l * (static_cast<Int128>(1) << static_cast<int>(r)); });
+            break;
+        case ASTNode::OperatorType::BRS:
+            if (!isShiftInRange) return result;
+            corners([](Int128 l, Int128 r) { return static_cast<Int128>(static_cast<int64_t>(l) >> static_cast<int>(r)); });
+            break;
+        default:
+            // Comparisons
+            return Interval{0, 1};
+    }
+
+    if (lo < result.lo || hi > result.hi) return result;
+    return Interval{static_cast<int64_t>(lo), static_cast<int64_t>(hi)};
+}
+
+void BoundsCheckEliminator::checkIndex(ArrayIndexNode& node, Interval index) {
+    const Symbol *symbol = node.identifier->symbolPtr;
+
+    if (index.lo >= 0 && index.hi < symbol->arraySize) {
+        if (Remarks::isEnabled()) {
+            Remarks::applied(node, std::format("removed the bounds check of `{}`", expressionText(&node)));
+        }
+
+        node.isIndexInBounds = true;
+        ++m_eliminatedCount;
+        return;
+    }
+
+    std::string indexText = index.lo == index.hi
+        ? std::to_string(index.lo)
+        : "in [" + std::to_string(index.lo) + ", " + std::to_string(index.hi) + "]";
+
+    if (Remarks::isEnabled()) {
+        Remarks::missed(node, std::format(
+            "kept the bounds check of `{}`: index {} against size {}", expressionText(&node), indexText, symbol->arraySize
+        ));
+    }
+
+    if (index.hi >= 0 && index.lo < symbol->arraySize) return;
+
+    std::cerr << std::format(
+        "{}:{}:{}: warning: index {} is out of bounds of the array '{}' of size {}\n",
+        m_filepath, node.m_line, node.m_column, indexText, node.identifier->name, symbol->arraySize
+    );
+    ++m_failingCount;
+}
+
+BoundsCheckEliminator::Interval BoundsCheckEliminator::rangeOf(const Symbol* symbol) const {
+    auto found = m_state.find(symbol);
+    return found != m_state.end() ? found->second : typeRange(symbol->type);
+}
+
+BoundsCheckEliminator::Interval BoundsCheckEliminator::typeRange(ASTNode::DataType type) {
+    switch (type) {
+        case ASTNode::DataType::CHAR:  return Interval{INT8_MIN, INT8_MAX};
+        case ASTNode::DataType::SHORT: return Interval{INT16_MIN, INT16_MAX};
+        case ASTNode::DataType::INT:   return Interval{INT32_MIN, INT32_MAX};
+        default:                       return Interval{INT64_MIN, INT64_MAX};
+    }
+}
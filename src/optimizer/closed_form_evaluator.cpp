@@ -0,0 +1,300 @@
+#include "closed_form_evaluator.hpp"
+#include "arithmetic.hpp"
+#include "remarks.hpp"
+
+#include <format>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+using OperatorType = ASTNode::OperatorType;
+using DataType = ASTNode::DataType;
+
+__extension__ using UInt128 = unsigned __int128;
+
+namespace {
+
+// a * v + c + invariant + self * s, the coefficients taken modulo 2^64
+struct Affine {
+    uint64_t coefficient = 0;
+    uint64_t constant = 0;
+    ExpressionSlot invariant; // Loop-invariant part, nullptr when there's none
+    uint64_t self = 0;        // Coefficient of the target of the update
+};
+
+int widthOf(DataType type) {
+    switch (type) {
+        case DataType::CHAR:  return 8;
+        case DataType::SHORT: return 16;
+        case DataType::INT:   return 32;
+        default:              return 64;
+    }
+}
+
+// Sum of two invariant parts, either of which may be missing; computed as long
+ExpressionSlot combine(OperatorType op, ExpressionSlot lhs, ExpressionSlot rhs, const ASTNode& origin) {
+    if (!rhs) return lhs;
+    if (!lhs) {
+        if (op == OperatorType::ADD) return rhs;
+        lhs = makeConstant(0, DataType::LONG, origin);
+    }
+
+    return makeBinary(op, std::move(lhs), std::move(rhs), DataType::LONG, origin);
+}
+
+ExpressionSlot scale(ExpressionSlot invariant, uint64_t factor, const ASTNode& origin) {
+    if (!invariant) return nullptr;
+
+    auto constant = makeConstant(static_cast<int64_t>(factor), DataType::LONG, origin);
+    return makeBinary(OperatorType::MULT, std::move(invariant), std::move(constant), DataType::LONG, origin);
+}
+
+// Whole value of an invariant affine form, as an expression
+ExpressionSlot materialize(Affine& form, const ASTNode& origin) {
+    auto constant = makeConstant(static_cast<int64_t>(form.constant), DataType::LONG, origin);
+    return combine(OperatorType::ADD, std::move(form.invariant), std::move(constant), origin);
+}
+
+// Decomposes `root` into an affine form of the loop variable and `target`. An operation
+// narrower than `target` would wrap differently than the form, so it must be an affine
+// function of the variable alone which the range proves never wraps; otherwise it's
+// returned in `narrow`.
+std::optional<Affine> decompose(
+    ExpressionNode& root, const ExpressionNode& variable, const LoopRange& range, const Symbol* target,
+    const std::unordered_set<Symbol*>& written, const BinaryOpNode*& narrow
+) {
+    int width = widthOf(target->type);
+
+    std::vector<std::pair<ExpressionNode*, bool>> nodes{{&root, false}};
+    std::vector<Affine> forms;
+
+    while (!nodes.empty()) {
+        auto [node, isExpanded] = nodes.back();
+        nodes.pop_back();
+
+        auto binary = dynamic_cast<BinaryOpNode*>(node);
+
+        if (isSameExpression(node, &variable)) {
+            forms.push_back(Affine{1, 0, nullptr});
+        } else if (auto self = dynamic_cast<IdentifierNode*>(node); self && self->symbolPtr == target) {
+            forms.push_back(Affine{0, 0, nullptr, 1});
+        } else if (binary && !isExpanded) {
+            if (widthOf(binary->resolvedType) < width) {
+                int64_t coefficient, constant;
+                if (!matchAffine(binary, &variable, coefficient, constant, &range)) {
+                    narrow = binary;
+                    return std::nullopt;
+                }
+
+                forms.push_back(Affine{static_cast<uint64_t>(coefficient), static_cast<uint64_t>(constant), nullptr});
+                continue;
+            }
+
+            nodes.emplace_back(node, true);
+            nodes.emplace_back(binary->right.get(), false);
+            nodes.emplace_back(binary->left.get(), false);
+        } else if (binary) {
+            Affine rhs = std::move(forms.back());
+            forms.pop_back();
+            Affine& lhs = forms.back();
+
+            switch (binary->op) {
+                case OperatorType::ADD:
+                case OperatorType::SUB: {
+                    bool isAdd = binary->op == OperatorType::ADD;
+                    lhs.coefficient = isAdd ? lhs.coefficient + rhs.coefficient : lhs.coefficient - rhs.coefficient;
+                    lhs.constant = isAdd ? lhs.constant + rhs.constant : lhs.constant - rhs.constant;
+                    lhs.self = isAdd ? lhs.self + rhs.self : lhs.self - rhs.self;
+                    lhs.invariant = combine(binary->op, std::move(lhs.invariant), std::move(rhs.invariant), *binary);
+                    break;
+                }
+                case OperatorType::MULT: {
+                    // One of the factors must be constant, or both invariant
+                    if (!rhs.invariant && rhs.coefficient == 0 && rhs.self == 0) {
+                        std::swap(lhs, rhs);
+                    }
+
+                    if (!lhs.invariant && lhs.coefficient == 0 && lhs.self == 0) {
+                        uint64_t factor = lhs.constant;
+                        lhs = Affine{
+                            rhs.coefficient * factor, rhs.constant * factor,
+                            scale(std::move(rhs.invariant), factor, *binary), rhs.self * factor
+                        };
+                    } else if (lhs.coefficient == 0 && rhs.coefficient == 0 && lhs.self == 0 && rhs.self == 0) {
+                        auto product = makeBinary(
+                            OperatorType::MULT, materialize(lhs, *binary), materialize(rhs, *binary), DataType::LONG, *binary
+                        );
+                        lhs = Affine{0, 0, std::move(product)};
+                    } else {
+                        return std::nullopt;
+                    }
+                    break;
+                }
+                default:
+                    return std::nullopt;
+            }
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+            if (written.count(identifier->symbolPtr)) return std::nullopt;
+            forms.push_back(Affine{0, 0, cloneExpression(identifier)});
+        } else if (auto element = dynamic_cast<ArrayIndexNode*>(node)) {
+            if (written.count(element->identifier->symbolPtr) || mayTrap(element)) return std::nullopt;
+            forms.push_back(Affine{0, 0, cloneExpression(element)});
+        } else {
+            int64_t value;
+            if (!constantValue(node, value)) return std::nullopt;
+            forms.push_back(Affine{0, static_cast<uint64_t>(value), nullptr});
+        }
+    }
+
+    return std::move(forms.back());
+}
+
+// Statements of the body, with nested blocks flattened; false if any isn't an assignment
+bool collectUpdates(StatementNode& body, std::vector<AssignmentNode*>& updates) {
+    std::vector<StatementNode*> pending{&body};
+
+    while (!pending.empty()) {
+        StatementNode *statement = pending.back();
+        pending.pop_back();
+
+        if (auto compound = dynamic_cast<CompoundStatementNode*>(statement)) {
+            for (auto it = compound->statements.rbegin(); it != compound->statements.rend(); ++it) {
+                pending.push_back(it->get());
+            }
+        } else if (auto assignment = dynamic_cast<AssignmentNode*>(statement)) {
+            updates.push_back(assignment);
+        } else if (auto empty = dynamic_cast<EmptyStatementNode*>(statement); !empty || !empty->trace.empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+void ClosedFormEvaluator::evaluate(ASTNode& root) {
+    markInitializedReads(root);
+    traverse(root);
+}
+
+size_t ClosedFormEvaluator::replacedCount() const {
+    return m_replacedCount;
+}
+
+// Inner loops are replaced first
+void ClosedFormEvaluator::postVisit(ASTNode& node) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        for (auto& statement : compound->statements) {
+            replace(statement);
+        }
+    } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        replace(forNode->body);
+    }
+}
+
+void ClosedFormEvaluator::replace(std::unique_ptr<StatementNode>& slot) {
+    auto loop = dynamic_cast<ForNode*>(slot.get());
+    CountedLoop counted;
+
+    if (!loop) return;
+
+    int64_t first;
+    uint64_t n;
+    if (!matchCountedLoop(*loop, counted) || !countIterations(*loop, counted, first, n)) {
+        Remarks::missed(*loop, "no closed form: trip count unknown");
+        return;
+    }
+
+    Symbol *symbol = counted.symbol;
+    // A loop which never runs only keeps its init, whatever the range
+    LoopRange range{first, first};
+    loopRange(*loop, counted, range);
+
+    std::unordered_set<Symbol*> written;
+    std::vector<AssignmentNode*> updates;
+    collectWrittenSymbols(*loop->body, written);
+
+    if (written.count(symbol)) {
+        Remarks::missed(*loop, "no closed form: the body writes the loop variable");
+        return;
+    }
+
+    if (!collectUpdates(*loop->body, updates)) {
+        Remarks::missed(*loop, "no closed form: the body isn't a sequence of assignments");
+        return;
+    }
+
+    // Sum of the values of the variable over all iterations, modulo 2^64
+    uint64_t halfProduct = static_cast<uint64_t>(static_cast<UInt128>(n) * (n == 0 ? 0 : n - 1) / 2);
+    uint64_t variableSum = n * static_cast<uint64_t>(first) + static_cast<uint64_t>(counted.step) * halfProduct;
+
+    auto replaced = std::make_unique<CompoundStatementNode>();
+    std::vector<std::unique_ptr<StatementNode>> results;
+
+    for (AssignmentNode* update : updates) {
+        // s = s + e, where e doesn't depend on s
+        auto target = dynamic_cast<IdentifierNode*>(update->left.get());
+        if (!target) {
+            Remarks::missed(*update, "no closed form: the loop stores to an array element");
+            return;
+        }
+
+        if (mayTrap(update->right.get())) {
+            if (Remarks::isEnabled()) {
+                Remarks::missed(*update, std::format("no closed form: `{}` may trap", expressionText(update->right.get())));
+            }
+            return;
+        }
+
+        const BinaryOpNode *narrow = nullptr;
+        auto form = decompose(*update->right, *counted.variable, range, target->symbolPtr, written, narrow);
+
+        if (narrow) {
+            if (Remarks::isEnabled()) {
+                Remarks::missed(*update, std::format(
+                    "no closed form: `{}` is computed as {}, narrower than `{}`, and may wrap around",
+                    expressionText(narrow), ASTNode::typeToString(narrow->resolvedType), target->name
+                ));
+            }
+            return;
+        }
+
+        if (!form || form->self != 1) {
+            if (Remarks::isEnabled()) {
+                Remarks::missed(*update, std::format(
+                    "no closed form: `{} = {}` doesn't add an affine function of the loop variable to `{}`",
+                    target->name, expressionText(update->right.get()), target->name
+                ));
+            }
+            return;
+        }
+
+        form->constant = form->coefficient * variableSum + form->constant * n;
+        form->invariant = scale(std::move(form->invariant), n, *update);
+
+        auto total = makeBinary(
+            OperatorType::ADD, cloneExpression(target), materialize(*form, *update), DataType::LONG, *update
+        );
+        results.push_back(makeAssignment(cloneExpression(target), std::move(total), *update));
+    }
+
+    replaced->statements.push_back(std::move(loop->init));
+
+    if (n > 0) {
+        for (auto& result : results) {
+            replaced->statements.push_back(std::move(result));
+        }
+
+        uint64_t exitValue = static_cast<uint64_t>(first) + n * static_cast<uint64_t>(counted.step);
+        auto value = makeConstant(static_cast<int64_t>(exitValue), symbol->type, *loop);
+        replaced->statements.push_back(makeAssignment(cloneExpression(counted.variable), std::move(value), *loop));
+    }
+
+    if (Remarks::isEnabled()) {
+        Remarks::applied(*loop, std::format("replaced loop of {} iteration(s) by its closed form", n));
+    }
+
+    slot = std::move(replaced);
+    ++m_replacedCount;
+}
@@ -0,0 +1,39 @@
+#include "constant_folder.hpp"
+#include "arithmetic.hpp"
+#include "ast_utils.hpp"
+#include "remarks.hpp"
+
+#include <format>
+
+void ConstantFolder::fold(ASTNode& root) {
+    traverse(root);
+}
+
+size_t ConstantFolder::foldedCount() const {
+    return m_foldedCount;
+}
+
+// Children are already folded, so a foldable operation has constant operands
+void ConstantFolder::postVisit(ASTNode& node) {
+    forEachExpressionSlot(node, [this](ExpressionSlot& slot) {
+        auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+        if (binary == nullptr) return;
+
+        int64_t lhs, rhs, result;
+
+        if (!constantValue(binary->left.get(), lhs) || !constantValue(binary->right.get(), rhs)) return;
+        if (!evaluateOperator(binary->op, lhs, rhs, binary->resolvedType, result)) {
+            if (Remarks::isEnabled()) {
+                Remarks::missed(*binary, std::format("cannot fold `{}`: it traps at runtime", expressionText(binary)));
+            }
+            return;
+        }
+
+        if (Remarks::isEnabled()) {
+            Remarks::applied(*binary, std::format("folded `{}` to {}", expressionText(binary), result));
+        }
+
+        slot = makeConstant(result, binary->resolvedType, *binary);
+        ++m_foldedCount;
+    });
+}
@@ -0,0 +1,371 @@
+#include "copy_propagator.hpp"
+#include "arithmetic.hpp"
+#include "remarks.hpp"
+
+#include <algorithm>
+#include <format>
+
+namespace {
+
+bool containsLoad(const ExpressionNode* node) {
+    std::vector<const ExpressionNode*> nodes{node};
+
+    while (!nodes.empty()) {
+        const ExpressionNode *current = nodes.back();
+        nodes.pop_back();
+
+        if (dynamic_cast<const ArrayIndexNode*>(current)) return true;
+
+        if (auto binary = dynamic_cast<const BinaryOpNode*>(current)) {
+            nodes.push_back(binary->left.get());
+            nodes.push_back(binary->right.get());
+        }
+    }
+
+    return false;
+}
+
+void collectReads(const ExpressionNode* node, std::vector<Symbol*>& reads) {
+    std::vector<const ExpressionNode*> nodes{node};
+
+    while (!nodes.empty()) {
+        const ExpressionNode *current = nodes.back();
+        nodes.pop_back();
+
+        if (auto identifier = dynamic_cast<const IdentifierNode*>(current)) {
+            reads.push_back(identifier->symbolPtr);
+        } else if (auto binary = dynamic_cast<const BinaryOpNode*>(current)) {
+            nodes.push_back(binary->left.get());
+            nodes.push_back(binary->right.get());
+        } else if (auto element = dynamic_cast<const ArrayIndexNode*>(current)) {
+            reads.push_back(element->identifier->symbolPtr);
+            nodes.push_back(element->indexExpression.get());
+        }
+    }
+}
+
+} // namespace
+
+CopyPropagator::CopyPropagator(SymbolTable& symbolTable) :
+    m_symbolTable(symbolTable)
+{}
+
+void CopyPropagator::propagate(ASTNode& root) {
+    markInitializedReads(root);
+    traverse(root);
+}
+
+size_t CopyPropagator::propagatedCount() const {
+    return m_propagatedCount;
+}
+
+size_t CopyPropagator::eliminatedLoadCount() const {
+    return m_eliminatedLoadCount;
+}
+
+// Statements are processed whole when they're reached, blocks and loops step by step
+bool CopyPropagator::preVisit(ASTNode& node) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        m_frames.push_back(std::make_unique<Frame>());
+        m_frames.back()->compound = compound;
+        return true;
+    }
+
+    if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+        processAssignment(*assignment, m_statementFrame, m_statement);
+        return false;
+    }
+
+    if (auto declaration = dynamic_cast<DeclarationNode*>(&node); declaration && !dynamic_cast<MainDeclNode*>(&node)) {
+        processDeclaration(*declaration, m_statementFrame, m_statement);
+        return false;
+    }
+
+    return !dynamic_cast<ExpressionNode*>(&node) && !dynamic_cast<EmptyStatementNode*>(&node);
+}
+
+// Steps of a loop: 0 - init and header, 1 - increment
+ASTNode* CopyPropagator::nextChild(ASTNode& node, size_t& step) {
+    if (dynamic_cast<CompoundStatementNode*>(&node)) {
+        m_statement = static_cast<StatementNode*>(node.child(step++));
+        m_statementFrame = m_frames.back().get();
+        return m_statement;
+    }
+
+    auto loop = dynamic_cast<ForNode*>(&node);
+    if (loop == nullptr) return node.child(step++);
+
+    if (step++ == 0) {
+        if (loop->init) processAssignment(*loop->init, nullptr, nullptr);
+
+        std::unordered_set<Symbol*> written;
+        collectWrittenSymbols(*loop, written);
+
+        for (Symbol* symbol : written) {
+            kill(symbol);
+        }
+
+        m_loopFacts.push_back(m_facts);
+
+        if (loop->condition) {
+            bool isTrapSeen = false;
+            rewrite(loop->condition, isTrapSeen, nullptr, nullptr);
+        }
+
+        m_statementFrame = nullptr;
+        m_statement = nullptr;
+        return loop->body.get();
+    }
+
+    if (loop->increment) processAssignment(*loop->increment, nullptr, nullptr);
+
+    // The loop is left from its header
+    m_facts = std::move(m_loopFacts.back());
+    m_loopFacts.pop_back();
+    return nullptr;
+}
+
+// Leaving a block: its temporaries are declared and its declarations go out of scope
+void CopyPropagator::postVisit(ASTNode& node) {
+    auto compound = dynamic_cast<CompoundStatementNode*>(&node);
+    if (compound == nullptr) return;
+
+    std::unique_ptr<Frame> frame = std::move(m_frames.back());
+    m_frames.pop_back();
+
+    for (auto& [statement, declaration] : frame->insertions) {
+        auto position = std::find_if(compound->statements.begin(), compound->statements.end(), [&](const auto& slot) {
+            return slot.get() == statement;
+        });
+        compound->statements.insert(position, std::move(declaration));
+    }
+
+    for (Symbol* symbol : frame->declared) {
+        kill(symbol);
+    }
+
+    for (const auto& load : m_loads) {
+        if (load->frame == frame.get()) load->frame = nullptr;
+    }
+}
+
+// The value is evaluated first, then the index of an element target
+void CopyPropagator::processAssignment(AssignmentNode& node, Frame* frame, StatementNode* statement) {
+    bool isTrapSeen = false;
+    rewrite(node.right, isTrapSeen, frame, statement);
+
+    if (auto element = dynamic_cast<ArrayIndexNode*>(node.left.get())) {
+        rewrite(element->indexExpression, isTrapSeen, frame, statement);
+        killElementStore(*element);
+
+        // The element holds the stored value, when it's stored without a conversion
+        auto source = dynamic_cast<IdentifierNode*>(node.right.get());
+        Symbol *array = element->identifier->symbolPtr;
+
+        if (source && source->resolvedType == array->type && !containsLoad(element->indexExpression.get())) {
+            Load *load = recordLoad(*element);
+            load->holder = source->symbolPtr;
+            load->holderName = source->name;
+        }
+    } else if (auto identifier = dynamic_cast<IdentifierNode*>(node.left.get())) {
+        kill(identifier->symbolPtr);
+        generate(identifier->symbolPtr, identifier->name, *node.right);
+    }
+}
+
+void CopyPropagator::processDeclaration(DeclarationNode& node, Frame* frame, StatementNode* statement) {
+    bool isTrapSeen = false;
+
+    if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+        Symbol *symbol = varDecl->identifier->symbolPtr;
+        if (varDecl->initExpression) rewrite(varDecl->initExpression, isTrapSeen, frame, statement);
+
+        kill(symbol);
+        for (Symbol* element : symbol->details().promotedElements) {
+            kill(element);
+        }
+
+        if (!m_frames.empty()) m_frames.back()->declared.insert(symbol);
+        if (varDecl->initExpression) generate(symbol, varDecl->identifier->name, *varDecl->initExpression);
+    } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+        Symbol *symbol = arrayDecl->identifier->symbolPtr;
+
+        for (auto& expression : arrayDecl->braceListInit) {
+            rewrite(expression, isTrapSeen, frame, statement);
+        }
+
+        kill(symbol);
+        for (Symbol* element : symbol->details().promotedElements) {
+            kill(element);
+        }
+
+        if (!m_frames.empty()) m_frames.back()->declared.insert(symbol);
+    }
+}
+
+// Walks the expression in evaluation order, replacing copies and redundant element reads
+void CopyPropagator::rewrite(ExpressionSlot& root, bool& isTrapSeen, Frame* frame, StatementNode* statement) {
+    struct Entry {
+        ExpressionSlot *slot;
+        bool isExpanded;
+        bool isTrapBefore; // Whether something evaluated before the subexpression may trap
+    };
+
+    std::vector<Entry> slots{{&root, false, false}};
+
+    while (!slots.empty()) {
+        Entry entry = slots.back();
+        slots.pop_back();
+
+        ExpressionNode *node = entry.slot->get();
+        auto binary = dynamic_cast<BinaryOpNode*>(node);
+        auto element = dynamic_cast<ArrayIndexNode*>(node);
+
+        if (entry.isExpanded) {
+            // A read replaced by a variable can't trap any more
+            if (!element || !rewriteLoad(*entry.slot, entry.isTrapBefore, frame, statement)) {
+                isTrapSeen = isTrapSeen || mayTrapItself(node);
+            }
+            continue;
+        }
+
+        if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+            isTrapSeen = isTrapSeen || mayTrapItself(identifier);
+
+            auto copy =std::find_if(m_facts.copies.begin(), m_facts.copies.end(), [&](const Copy& copy) {
+                return copy.target == identifier->symbolPtr;
+            });
+
+            if (copy != m_facts.copies.end()) {
+                if (Remarks::isEnabled()) {
+                    Remarks::applied(*identifier, std::format("replaced `{}` by its copy `{}`", identifier->name, copy->sourceName));
+                }
+
+                *entry.slot = makeIdentifier(copy->source, copy->sourceName, *identifier);
+                ++m_propagatedCount;
+            }
+        } else if (binary) {
+            slots.push_back({entry.slot, true, false});
+            slots.push_back({&binary->right, false, false});
+            slots.push_back({&binary->left, false, false});
+        } else if (element) {
+            slots.push_back({entry.slot, true, isTrapSeen});
+            slots.push_back({&element->indexExpression, false, false});
+        }
+    }
+}
+
+bool CopyPropagator::rewriteLoad(ExpressionSlot& slot, bool isTrapBefore, Frame* frame, StatementNode* statement) {
+    auto element = static_cast<ArrayIndexNode*>(slot.get());
+
+    auto found = std::find_if(m_facts.loads.begin(), m_facts.loads.end(), [&](const Load* load) {
+        return isSameExpression(load->pattern, element);
+    });
+
+    if (found != m_facts.loads.end()) {
+        Load& load = **found;
+        if (load.holder == nullptr && load.frame) hoist(load);
+
+        if (load.holder) {
+            if (Remarks::isEnabled()) {
+                Remarks::applied(*element, std::format("reused the value of `{}` loaded before", expressionText(element)));
+            }
+
+            slot = makeIdentifier(load.holder, load.holderName, *element);
+            ++m_eliminatedLoadCount;
+            return true;
+        }
+    } else if (!containsLoad(element->indexExpression.get())) {
+        Load *load = recordLoad(*element);
+
+        // Moving the read ahead of its statement mustn't change which error is raised first
+        if (frame && !isTrapBefore) {
+            load->firstSlot = &slot;
+            load->frame = frame;
+            load->statement = statement;
+        }
+    }
+
+    return false;
+}
+
+// The first read becomes the initializer of a temporary declared before its statement
+void CopyPropagator::hoist(Load& load) {
+    ExpressionSlot& slot = *load.firstSlot;
+    const ExpressionNode& origin = *slot;
+
+    auto declaration = declareTemporary(m_symbolTable, "load", origin.resolvedType, std::move(slot), origin);
+    slot = cloneExpression(declaration->identifier.get());
+
+    load.holder = declaration->identifier->symbolPtr;
+    load.holderName = declaration->identifier->name;
+    load.firstSlot = nullptr;
+
+    load.frame->declared.insert(load.holder);
+    load.frame->insertions.emplace_back(load.statement, std::move(declaration));
+    load.frame = nullptr;
+}
+
+CopyPropagator::Load* CopyPropagator::recordLoad(const ArrayIndexNode& pattern) {
+    auto load = std::make_unique<Load>();
+    load->pattern = &pattern;
+    collectReads(&pattern, load->reads);
+
+    m_facts.loads.push_back(load.get());
+    m_loads.push_back(std::move(load));
+    return m_loads.back().get();
+}
+
+// Facts established by storing `value` to a scalar, when no conversion is involved
+void CopyPropagator::generate(Symbol* target, const std::string& targetName, ExpressionNode& value) {
+    if (value.resolvedType != target->type) return;
+
+    if (auto source = dynamic_cast<IdentifierNode*>(&value)) {
+        if (source->symbolPtr != target && !source->symbolPtr->isArray) {
+            m_facts.copies.push_back({target, source->symbolPtr, source->name});
+        }
+        return;
+    }
+
+    auto element = dynamic_cast<ArrayIndexNode*>(&value);
+    if (element == nullptr || containsLoad(element->indexExpression.get())) return;
+
+    // The element was read without being held by a variable so far; now it's held by the target
+    auto found = std::find_if(m_facts.loads.begin(), m_facts.loads.end(), [&](const Load* load) {
+        return isSameExpression(load->pattern, element);
+    });
+
+    Load *load = found != m_facts.loads.end() ? *found : recordLoad(*element);
+    if (std::find(load->reads.begin(), load->reads.end(), target) != load->reads.end()) {
+        m_facts.loads.erase(std::find(m_facts.loads.begin(), m_facts.loads.end(), load));
+        return;
+    }
+
+    load->holder = target;
+    load->holderName = targetName;
+    load->firstSlot = nullptr;
+    load->frame = nullptr;
+}
+
+void CopyPropagator::kill(Symbol* symbol) {
+    std::erase_if(m_facts.copies, [symbol](const Copy& copy) {
+        return copy.target == symbol || copy.source == symbol;
+    });
+
+    std::erase_if(m_facts.loads, [symbol](const Load* load) {
+        return load->holder == symbol || std::find(load->reads.begin(), load->reads.end(), symbol) != load->reads.end();
+    });
+}
+
+// A store to an element keeps the reads of the elements which are certainly different
+void CopyPropagator::killElementStore(const ArrayIndexNode& element) {
+    int64_t index = 0;
+    bool isConstant = constantValue(element.indexExpression.get(), index);
+
+    std::erase_if(m_facts.loads, [&](const Load* load) {
+        if (load->pattern->identifier->symbolPtr != element.identifier->symbolPtr) return false;
+
+        int64_t other = 0;
+        return !isConstant || !constantValue(load->pattern->indexExpression.get(), other) || other == index;
+    });
+}
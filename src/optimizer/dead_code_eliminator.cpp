@@ -0,0 +1,181 @@
+#include "dead_code_eliminator.hpp"
+#include "ast_utils.hpp"
+#include "remarks.hpp"
+
+#include <format>
+
+namespace {
+
+// Collects every symbol whose value is read; the target of a scalar store isn't a read.
+// Stores which may trap are never removed, so their targets are collected as stored.
+class ReadCollector : public Traversal {
+public:
+    ReadCollector(std::unordered_set<const Symbol*>& read, std::unordered_set<const Symbol*>& stored) :
+        m_read(read), m_stored(stored)
+    {}
+
+    void collect(ASTNode& node) { traverse(node); }
+
+private:
+    bool preVisit(ASTNode& node) override {
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            m_target = assignment->left.get();
+            auto target = dynamic_cast<IdentifierNode*>(assignment->left.get());
+            if (target && mayTrap(assignment->right.get())) m_stored.insert(target->symbolPtr);
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(&node); identifier && identifier != m_target) {
+            m_read.insert(identifier->symbolPtr);
+            // A promoted element is initialized by the declaration of its array
+            if (identifier->symbolPtr->details().elementOf) m_read.insert(identifier->symbolPtr->details().elementOf);
+        }
+
+        return true;
+    }
+
+    std::unordered_set<const Symbol*>& m_read;
+    std::unordered_set<const Symbol*>& m_stored;
+    const ASTNode *m_target = nullptr; // Left side of the assignment being visited
+};
+
+} // namespace
+
+void DeadCodeEliminator::eliminate(ASTNode& root) {
+    do {
+        m_isChanged = false;
+        m_readSymbols.clear();
+        m_storedSymbols.clear();
+        // A value read before it's initialized raises an error: `int y = x;`,
+        // `long t = b[1];` and `r = q[0];` stay even when their target is never read
+        markInitializedReads(root);
+        ReadCollector(m_readSymbols, m_storedSymbols).collect(root);
+        traverse(root);
+    } while (m_isChanged);
+}
+
+const DeadCodeReport& DeadCodeEliminator::report() const {
+    return m_report;
+}
+
+// Nested blocks are pruned first, so a block left empty is removed by its parent
+void DeadCodeEliminator::postVisit(ASTNode& node) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        prune(compound->statements);
+    } else if (auto program = dynamic_cast<ProgramNode*>(&node)) {
+        prune(program->declarations);
+    } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        if (isDeadStore(forNode->init.get())) {
+            remarkDeadStore(*forNode->init);
+            forNode->init.reset();
+            ++m_report.deadStores;
+            m_isChanged = true;
+        }
+
+        if (isDeadStore(forNode->increment.get())) {
+            remarkDeadStore(*forNode->increment);
+            forNode->increment.reset();
+            ++m_report.deadStores;
+            m_isChanged = true;
+        }
+
+        // The body must stay a statement, an empty block costs nothing to run
+        if (!dynamic_cast<CompoundStatementNode*>(forNode->body.get()) && isDead(*forNode->body)) {
+            forNode->body = std::make_unique<CompoundStatementNode>();
+        }
+    }
+}
+
+template<typename Statement>
+void DeadCodeEliminator::prune(std::vector<std::unique_ptr<Statement>>& statements) {
+    size_t kept = 0;
+    bool isReachable = true;
+
+    for (auto& statement : statements) {
+        if (!isReachable) {
+            Remarks::applied(*statement, "removed unreachable statement");
+            ++m_report.unreachableStatements;
+            m_isChanged = true;
+            continue;
+        }
+
+        if (isDead(*statement)) continue;
+
+        // A loop without a condition never terminates
+        if (auto forNode = dynamic_cast<ForNode*>(statement.get()); forNode && !forNode->condition) {
+            isReachable = false;
+        }
+
+        statements[kept++] = std::move(statement);
+    }
+
+    statements.resize(kept);
+}
+
+bool DeadCodeEliminator::isDead(ASTNode& statement) {
+    // Statements removed by other passes are kept for their trace
+    if (auto empty = dynamic_cast<EmptyStatementNode*>(&statement); empty && empty->trace.empty()) {
+        ++m_report.emptyStatements;
+        return true;
+    }
+
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&statement)) {
+        if (!compound->statements.empty()) return false;
+        ++m_report.emptyBlocks;
+        return true;
+    }
+
+    if (auto assignment = dynamic_cast<AssignmentNode*>(&statement)) {
+        if (!isDeadStore(assignment)) return false;
+        remarkDeadStore(*assignment);
+        ++m_report.deadStores;
+        m_isChanged = true;
+        return true;
+    }
+
+    const IdentifierNode *declared;
+
+    if (auto varDecl = dynamic_cast<VariableDeclNode*>(&statement)) {
+        declared = varDecl->identifier.get();
+        if (m_readSymbols.count(declared->symbolPtr)) return false;
+        if (varDecl->initExpression && mayTrap(varDecl->initExpression.get())) return keepTrapping(*declared, "its initializer");
+        if (m_storedSymbols.count(declared->symbolPtr)) return keepTrapping(*declared, "a store to it");
+    } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&statement)) {
+        declared = arrayDecl->identifier.get();
+        if (m_readSymbols.count(declared->symbolPtr)) return false;
+
+        for (const auto& expression : arrayDecl->braceListInit) {
+            if (mayTrap(expression.get())) return keepTrapping(*declared, "its initializer");
+        }
+    } else {
+        return false;
+    }
+
+    if (Remarks::isEnabled()) {
+        Remarks::applied(statement, std::format("removed unused declaration of `{}`", declared->name));
+    }
+
+    ++m_report.unusedDeclarations;
+    m_isChanged = true;
+    return true;
+}
+
+// Element stores aren't dead: the array is referenced by the store itself
+bool DeadCodeEliminator::isDeadStore(const AssignmentNode* assignment) const {
+    if (assignment == nullptr) return false;
+
+    auto target = dynamic_cast<const IdentifierNode*>(assignment->left.get());
+    return target && !m_readSymbols.count(target->symbolPtr) && !mayTrap(assignment->right.get());
+}
+
+void DeadCodeEliminator::remarkDeadStore(const AssignmentNode& assignment) const {
+    if (Remarks::isEnabled()) {
+        auto target = static_cast<const IdentifierNode*>(assignment.left.get());
+        Remarks::applied(assignment, std::format("removed store to `{}`, which is never read", target->name));
+    }
+}
+
+bool DeadCodeEliminator::keepTrapping(const IdentifierNode& declared, std::string_view reason) const {
+    if (Remarks::isEnabled()) {
+        Remarks::missed(declared, std::format("kept unused declaration of `{}`: {} may trap", declared.name, reason));
+    }
+
+    return false;
+}
@@ -0,0 +1,176 @@
+#include "dead_store_eliminator.hpp"
+#include "arithmetic.hpp"
+#include "ast_utils.hpp"
+#include "traversal.hpp"
+#include "remarks.hpp"
+
+#include <format>
+#include <functional>
+#include <optional>
+#include <unordered_set>
+
+namespace {
+
+// Element index of a location which stands for a scalar, and of a read of an unknown element
+constexpr int64_t SCALAR = -1;
+constexpr int64_t ANY_ELEMENT = -2;
+
+// Reports every location read inside a node; store targets aren't reads
+class ReadCollector : public Traversal {
+public:
+    using Callback = std::function<void(const Symbol*, int64_t)>;
+
+    explicit ReadCollector(Callback callback) : m_callback(std::move(callback)) {}
+
+    void collect(ASTNode& node) { traverse(node); }
+
+private:
+    bool preVisit(ASTNode& node) override {
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            if (auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get())) {
+                m_skipped.insert(element);
+                m_skipped.insert(element->identifier.get());
+            } else {
+                m_skipped.insert(assignment->left.get());
+            }
+        } else if (auto element = dynamic_cast<ArrayIndexNode*>(&node)) {
+            m_skipped.insert(element->identifier.get());
+            if (m_skipped.count(element)) return true;
+
+            int64_t index;
+            bool isConstant = constantValue(element->indexExpression.get(), index) && index >= 0;
+            m_callback(element->identifier->symbolPtr, isConstant ? index : ANY_ELEMENT);
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(&node); identifier && !m_skipped.count(identifier)) {
+            m_callback(identifier->symbolPtr, SCALAR);
+        }
+
+        return true;
+    }
+
+    Callback m_callback;
+    std::unordered_set<const ASTNode*> m_skipped; // Targets of the stores met so far
+};
+
+} // namespace
+
+void DeadStoreEliminator::eliminate(ASTNode& root) {
+    markInitializedReads(root);
+
+    if (auto program = dynamic_cast<ProgramNode*>(&root)) {
+        for (auto& declaration : program->declarations) {
+            if (auto mainDecl = dynamic_cast<MainDeclNode*>(declaration.get())) scan(*mainDecl->body);
+        }
+    } else if (auto mainDecl = dynamic_cast<MainDeclNode*>(&root)) {
+        scan(*mainDecl->body);
+    }
+}
+
+size_t DeadStoreEliminator::removedCount() const {
+    return m_removedCount;
+}
+
+// Nested blocks are scanned with an explicit stack of frames, continuing the
+// backward flow of the enclosing block
+void DeadStoreEliminator::scan(CompoundStatementNode& body) {
+    m_dead.clear();
+
+    std::vector<Frame> frames;
+    frames.push_back(Frame{body.statements.data(), body.statements.size(), nullptr, {}});
+
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+
+        if (frame.remaining > 0) {
+            scanStatement(frame.begin[--frame.remaining], frames);
+            continue;
+        }
+
+        ForNode *loop = frame.loop;
+
+        // The body may not run at all, the loop is entered with its initial store
+        if (loop) m_dead = std::move(frame.deadAfter);
+        frames.pop_back();
+
+        if (loop && loop->init) scanStore(*loop->init, nullptr);
+    }
+}
+
+void DeadStoreEliminator::scanStatement(std::unique_ptr<StatementNode>& slot, std::vector<Frame>& frames) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(slot.get())) {
+        frames.push_back(Frame{compound->statements.data(), compound->statements.size(), nullptr, {}});
+    } else if (auto loop = dynamic_cast<ForNode*>(slot.get())) {
+        // Whatever the loop reads is live at the end of its body and before it
+        markRead(*loop);
+        frames.push_back(Frame{&loop->body, 1, loop, m_dead});
+    } else if (auto assignment = dynamic_cast<AssignmentNode*>(slot.get())) {
+        scanStore(*assignment, &slot);
+    } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(slot.get())) {
+        Symbol *symbol = varDecl->identifier->symbolPtr;
+        Location location{symbol, SCALAR};
+
+        if (varDecl->initExpression && m_dead.count(location) && !mayTrap(varDecl->initExpression.get())) {
+            remove(slot, symbol, "[Declaration]: " + varDecl->identifier->name + " = (eliminated)");
+            return;
+        }
+
+        // Nothing before the declaration refers to the variable
+        m_dead.erase(m_dead.lower_bound({symbol, ANY_ELEMENT}), m_dead.upper_bound({symbol, INT64_MAX}));
+        if (varDecl->initExpression) markRead(*varDecl->initExpression);
+    } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(slot.get())) {
+        const Symbol *symbol = arrayDecl->identifier->symbolPtr;
+        m_dead.erase(m_dead.lower_bound({symbol, ANY_ELEMENT}), m_dead.upper_bound({symbol, INT64_MAX}));
+        markRead(*arrayDecl);
+    }
+}
+
+// `slot` is nullptr for the initial store of a loop, which is never removed
+void DeadStoreEliminator::scanStore(AssignmentNode& assignment, std::unique_ptr<StatementNode>* slot) {
+    std::optional<Location> target;
+    std::string name;
+
+    if (auto identifier = dynamic_cast<IdentifierNode*>(assignment.left.get())) {
+        target = Location{identifier->symbolPtr, SCALAR};
+        name = identifier->name;
+    } else if (auto element = dynamic_cast<ArrayIndexNode*>(assignment.left.get())) {
+        const Symbol *symbol = element->identifier->symbolPtr;
+        int64_t index;
+
+        // An index out of bounds traps, so only the stores within bounds are known
+        if (constantValue(element->indexExpression.get(), index) && index >= 0 && index < symbol->arraySize) {
+            target = Location{symbol, index};
+            name = element->identifier->name + "[" + std::to_string(index) + "]";
+        }
+
+        markRead(*element->indexExpression);
+    }
+
+    if (slot && target && m_dead.count(*target) && !mayTrap(assignment.right.get())) {
+        if (Remarks::isEnabled()) {
+            Remarks::applied(assignment, std::format("removed store to `{}`, which is overwritten before it's read", name));
+        }
+
+        remove(*slot, target->first, "[Assignment]: " + name + " = (eliminated)");
+        return;
+    }
+
+    if (target) m_dead.insert(*target);
+    markRead(*assignment.right);
+}
+
+void DeadStoreEliminator::markRead(ASTNode& node) {
+    ReadCollector([this](const Symbol* symbol, int64_t index) {
+        if (index == ANY_ELEMENT) {
+            m_dead.erase(m_dead.lower_bound({symbol, ANY_ELEMENT}), m_dead.upper_bound({symbol, INT64_MAX}));
+        } else {
+            m_dead.erase({symbol, index});
+        }
+    }).collect(node);
+}
+
+void DeadStoreEliminator::remove(std::unique_ptr<StatementNode>& slot, const Symbol* symbol, const std::string& trace) {
+    auto marker = std::make_unique<EmptyStatementNode>(slot->m_line, slot->m_column);
+    if (!symbol->isCompilerTemporary) marker->trace = trace;
+
+    slot = std::move(marker);
+    ++m_removedCount;
+}
@@ -0,0 +1,266 @@
+#include "loop_fuser.hpp"
+#include "arithmetic.hpp"
+#include "remarks.hpp"
+
+#include <algorithm>
+#include <format>
+#include <vector>
+
+namespace {
+
+struct Access {
+    Symbol *array;
+    const ExpressionNode *subscript;
+    bool isStore;
+};
+
+// Symbols a statement reads and writes, the element accesses, whether anything in it may
+// trap, and whether it prints a line to the trace
+struct Effects {
+    std::unordered_set<Symbol*> reads;
+    std::unordered_set<Symbol*> writes;
+    std::vector<Access> accesses;
+    bool mayTrap = false;
+    bool isTraced = false;
+};
+
+// An element access whose subscript stays within bounds over the range of the variable doesn't trap
+class EffectCollector : public Traversal {
+public:
+    EffectCollector(Effects& effects, const ExpressionNode* variable, const LoopRange* range) :
+        m_effects(effects), m_variable(variable), m_range(range)
+    {}
+
+    void collect(ASTNode& node) { traverse(node); }
+    void collectExpression(const ExpressionNode* root) { read(root); }
+
+private:
+    bool preVisit(ASTNode& node) override {
+        if (dynamic_cast<ExpressionNode*>(&node)) return false;
+
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            read(assignment->right.get());
+
+            if (auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get())) {
+                read(element->indexExpression.get());
+                m_effects.accesses.push_back({element->identifier->symbolPtr, element->indexExpression.get(), true});
+                m_effects.writes.insert(element->identifier->symbolPtr);
+                m_effects.mayTrap = m_effects.mayTrap || mayTrapAccess(*element);
+            } else if (auto identifier = dynamic_cast<IdentifierNode*>(assignment->left.get())) {
+                m_effects.writes.insert(identifier->symbolPtr);
+            }
+
+            m_effects.isTraced = m_effects.isTraced || isTraced(*assignment);
+            return false;
+        }
+
+        m_effects.isTraced = m_effects.isTraced || isTraced(node);
+
+        forEachExpressionSlot(node, [this](ExpressionSlot& slot) { read(slot.get()); });
+        collectWrittenSymbols(node, m_effects.writes);
+        return true;
+    }
+
+    void read(const ExpressionNode* root) {
+        std::vector<const ExpressionNode*> nodes{root};
+
+        while (!nodes.empty()) {
+            const ExpressionNode *node = nodes.back();
+            nodes.pop_back();
+
+            auto access = dynamic_cast<const ArrayIndexNode*>(node);
+            m_effects.mayTrap = m_effects.mayTrap || (access ? mayTrapAccess(*access) : mayTrapItself(node));
+
+            if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+                m_effects.reads.insert(identifier->symbolPtr);
+            } else if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+                nodes.push_back(binary->left.get());
+                nodes.push_back(binary->right.get());
+            } else if (auto element = dynamic_cast<const ArrayIndexNode*>(node)) {
+                m_effects.reads.insert(element->identifier->symbolPtr);
+                m_effects.accesses.push_back({element->identifier->symbolPtr, element->indexExpression.get(), false});
+                nodes.push_back(element->indexExpression.get());
+            }
+        }
+    }
+
+    // Stores to compiler temporaries and declarations without a value print nothing
+    static bool isTraced(const ASTNode& statement) {
+        if (auto assignment = dynamic_cast<const AssignmentNode*>(&statement)) {
+            auto identifier = dynamic_cast<const IdentifierNode*>(assignment->left.get());
+            return !identifier || !identifier->symbolPtr->isCompilerTemporary;
+        }
+
+        if (auto varDecl = dynamic_cast<const VariableDeclNode*>(&statement)) {
+            const Symbol *symbol = varDecl->identifier->symbolPtr;
+            return symbol->isArray || (varDecl->initExpression && !symbol->isCompilerTemporary);
+        }
+
+        if (auto empty = dynamic_cast<const EmptyStatementNode*>(&statement)) return !empty->trace.empty();
+        return dynamic_cast<const ArrayDeclNode*>(&statement) != nullptr;
+    }
+
+    bool mayTrapAccess(const ArrayIndexNode& element) const {
+        if (!mayTrapItself(&element)) return false;
+        // The range only proves the subscript in bounds
+        if (m_range == nullptr || !element.isInitialized) return true;
+
+        int64_t coefficient, constant;
+        if (!matchAffine(element.indexExpression.get(), m_variable, coefficient, constant, m_range)) return true;
+
+        // The ends of the range give the smallest and the largest subscript
+        int64_t size = element.identifier->symbolPtr->arraySize;
+        int64_t first = coefficient * m_range->first + constant;
+        int64_t last = coefficient * m_range->last + constant;
+        return std::min(first, last) < 0 || std::max(first, last) >= size;
+    }
+
+    Effects& m_effects;
+    const ExpressionNode *m_variable;
+    const LoopRange *m_range;
+};
+
+// True when the access of the first body in iteration p and the access of the
+// second body in iteration q may reach the same element for some p > q
+bool mayConflict(const Access& first, const Access& second, const ExpressionNode* variable) {
+    int64_t c1, d1, c2, d2;
+
+    if (!matchAffine(first.subscript, variable, c1, d1) || !matchAffine(second.subscript, variable, c2, d2)) return true;
+    if (c1 != c2) return true;
+    if (c1 == 0) return d1 == d2;
+
+    // c * p + d1 == c * q + d2  <=>  p - q == (d2 - d1) / c
+    int64_t difference;
+    if (__builtin_sub_overflow(d2, d1, &difference)) return true;
+
+    return difference % c1 == 0 && difference / c1 > 0;
+}
+
+bool intersects(const std::unordered_set<Symbol*>& lhs, const std::unordered_set<Symbol*>& rhs) {
+    return std::any_of(lhs.begin(), lhs.end(), [&rhs](Symbol* symbol) { return rhs.count(symbol); });
+}
+
+// Loops with the same header which stay apart
+bool reject(const ForNode& second, const std::string& reason) {
+    Remarks::missed(second, "cannot fuse with the loop before: " + reason);
+    return false;
+}
+
+} // namespace
+
+void LoopFuser::fuse(ASTNode& root) {
+    markInitializedReads(root);
+    traverse(root);
+}
+
+size_t LoopFuser::fusedCount() const {
+    return m_fusedCount;
+}
+
+// Inner blocks are processed first; a fused loop is tried again with the loop after it
+void LoopFuser::postVisit(ASTNode& node) {
+    auto compound = dynamic_cast<CompoundStatementNode*>(&node);
+    if (compound == nullptr) return;
+
+    auto& statements = compound->statements;
+
+    for (size_t i = 0; i + 1 < statements.size();) {
+        auto first = dynamic_cast<ForNode*>(statements[i].get());
+        auto second = dynamic_cast<ForNode*>(statements[i + 1].get());
+
+        if (first && second && tryFuse(*first, *second)) {
+            statements.erase(statements.begin() + i + 1);
+            ++m_fusedCount;
+        } else {
+            ++i;
+        }
+    }
+}
+
+bool LoopFuser::tryFuse(ForNode& first, ForNode& second) {
+    if (!first.init || !first.condition || !first.increment) return false;
+    if (!second.init || !second.condition || !second.increment) return false;
+
+    auto variable = dynamic_cast<IdentifierNode*>(first.init->left.get());
+    if (!variable || variable->symbolPtr->isArray) return false;
+
+    if (!isSameExpression(first.init->left.get(), second.init->left.get()) ||
+        !isSameExpression(first.init->right.get(), second.init->right.get()) ||
+        !isSameExpression(first.condition.get(), second.condition.get()) ||
+        !isSameExpression(first.increment->left.get(), second.increment->left.get()) ||
+        !isSameExpression(first.increment->right.get(), second.increment->right.get())) {
+        return false;
+    }
+
+    Symbol *symbol = variable->symbolPtr;
+
+    // The range of a counted loop is known; the bodies are checked not to write the variable below
+    CountedLoop counted;
+    LoopRange bounds;
+    const LoopRange *range = nullptr;
+
+    if (matchCountedLoop(first, counted) && loopRange(first, counted, bounds)) {
+        range = &bounds;
+    }
+
+    Effects firstBody, secondBody, header, init;
+    EffectCollector(firstBody, variable, range).collect(*first.body);
+    EffectCollector(secondBody, variable, range).collect(*second.body);
+    EffectCollector(header, variable, nullptr).collectExpression(first.condition.get());
+    EffectCollector(header, variable, nullptr).collectExpression(first.increment->right.get());
+    EffectCollector(init, variable, nullptr).collectExpression(first.init->right.get());
+
+    // Both loops run the same iterations
+    if (firstBody.writes.count(symbol) || secondBody.writes.count(symbol) || init.reads.count(symbol)) {
+        return reject(second, "the loop variable changes in a body");
+    }
+    if (intersects(init.reads, firstBody.writes)) return reject(second, "the first body changes the initial value");
+
+    header.reads.erase(symbol);
+    if (intersects(header.reads, firstBody.writes) || intersects(header.reads, secondBody.writes)) {
+        return reject(second, "a body changes the bound or the step");
+    }
+
+    if (firstBody.mayTrap || secondBody.mayTrap) return reject(second, "a body may trap");
+    if (firstBody.isTraced && secondBody.isTraced) return reject(second, "both bodies print to the trace");
+
+    // Scalars flow from one body to the other only through the variable
+    for (Symbol* written : firstBody.writes) {
+        if (!written->isArray && (secondBody.reads.count(written) || secondBody.writes.count(written))) {
+            return reject(second, "the bodies share a scalar");
+        }
+    }
+    for (Symbol* written : secondBody.writes) {
+        if (!written->isArray && firstBody.reads.count(written)) return reject(second, "the bodies share a scalar");
+    }
+
+    // The elements one body stores to may only be accessed by the other in the original order
+    for (const Access& lhs : firstBody.accesses) {
+        for (const Access& rhs : secondBody.accesses) {
+            if (lhs.array != rhs.array || (!lhs.isStore && !rhs.isStore)) continue;
+            if (mayConflict(lhs, rhs, variable)) {
+                if (Remarks::isEnabled()) {
+                    reject(second, std::format(
+                        "the array accesses at subscripts `{}` and `{}` may conflict across iterations",
+                        expressionText(lhs.subscript), expressionText(rhs.subscript)
+                    ));
+                }
+                return false;
+            }
+        }
+    }
+
+    // The bodies stay blocks of their own; a loop fused again gets one more
+    if (!m_fusedBodies.count(first.body.get())) {
+        auto body = std::make_unique<CompoundStatementNode>();
+        body->statements.push_back(std::move(first.body));
+        first.body = std::move(body);
+        m_fusedBodies.insert(first.body.get());
+    }
+
+    static_cast<CompoundStatementNode*>(first.body.get())->statements.push_back(std::move(second.body));
+    if (Remarks::isEnabled()) {
+        Remarks::applied(first, std::format("fused the loop at {}:{} into this one", second.m_line, second.m_column));
+    }
+    return true;
+}
@@ -0,0 +1,222 @@
+#include "loop_invariant_mover.hpp"
+#include "remarks.hpp"
+
+#include <format>
+#include <functional>
+
+namespace {
+
+// Reports the expressions evaluated by the statements of a loop body, outermost first
+class RootCollector : public Traversal {
+public:
+    explicit RootCollector(std::function<void(ExpressionSlot&)> callback) : m_callback(std::move(callback)) {}
+
+    void collect(ASTNode& node) { traverse(node); }
+
+private:
+    bool preVisit(ASTNode& node) override {
+        if (dynamic_cast<ExpressionNode*>(&node)) return false;
+
+        if (auto assignment = dynamic_cast<AssignmentNode*>(&node)) {
+            // The target of an element store is not a value, only its index is
+            if (auto element = dynamic_cast<ArrayIndexNode*>(assignment->left.get())) {
+                m_callback(element->indexExpression);
+            }
+
+            m_callback(assignment->right);
+        } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+            if (forNode->condition) m_callback(forNode->condition);
+        } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+            if (varDecl->initExpression) m_callback(varDecl->initExpression);
+        } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+            for (auto& expression : arrayDecl->braceListInit) {
+                m_callback(expression);
+            }
+        }
+
+        return true;
+    }
+
+    std::function<void(ExpressionSlot&)> m_callback;
+};
+
+bool isScalarType(ASTNode::DataType type) {
+    return type == ASTNode::DataType::CHAR || type == ASTNode::DataType::SHORT ||
+        type == ASTNode::DataType::INT || type == ASTNode::DataType::LONG;
+}
+
+} // namespace
+
+LoopInvariantMover::LoopInvariantMover(SymbolTable& symbolTable) :
+    m_symbolTable(symbolTable)
+{}
+
+void LoopInvariantMover::hoist(ASTNode& root) {
+    markInitializedReads(root);
+    traverse(root);
+}
+
+size_t LoopInvariantMover::hoistedCount() const {
+    return m_hoistedCount;
+}
+
+void LoopInvariantMover::postVisit(ASTNode& node) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        for (auto& statement : compound->statements) {
+            hoistFrom(statement);
+        }
+    } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        hoistFrom(forNode->body);
+    }
+}
+
+void LoopInvariantMover::hoistFrom(std::unique_ptr<StatementNode>& slot) {
+    auto loop = dynamic_cast<ForNode*>(slot.get());
+    if (loop == nullptr) return;
+
+    m_loop = loop;
+    m_written.clear();
+    m_candidates.clear();
+    collectWrittenSymbols(*loop, m_written);
+
+    // The condition goes first, its temporary must be the first one to be evaluated
+    if (loop->condition) collectInvariants(loop->condition, true);
+
+    // The body and the increment may not run at all otherwise
+    if (runsAtLeastOnce(*loop)) {
+        if (loop->increment) {
+            if (auto element = dynamic_cast<ArrayIndexNode*>(loop->increment->left.get())) {
+                collectInvariants(element->indexExpression, false);
+            }
+
+            collectInvariants(loop->increment->right, false);
+        }
+
+        RootCollector([this](ExpressionSlot& root) { collectInvariants(root, false); }).collect(*loop->body);
+    }
+
+    if (m_candidates.empty()) return;
+
+    auto hoisted = std::make_unique<CompoundStatementNode>();
+    if (loop->init) hoisted->statements.push_back(std::move(loop->init));
+
+    std::vector<VariableDeclNode*> temporaries;
+
+    for (ExpressionSlot* candidate : m_candidates) {
+        VariableDeclNode *temporary = nullptr;
+
+        // Equal expressions share a temporary
+        for (VariableDeclNode* existing : temporaries) {
+            if (isSameExpression(existing->initExpression.get(), candidate->get())) {
+                temporary = existing;
+                break;
+            }
+        }
+
+        if (temporary == nullptr) {
+            const ExpressionNode& origin = **candidate;
+            auto declaration = declareTemporary(
+                m_symbolTable, "licm", origin.resolvedType, std::move(*candidate), origin
+            );
+
+            if (Remarks::isEnabled()) {
+                Remarks::applied(origin, std::format(
+                    "hoisted invariant `{}` out of loop at {}:{}", expressionText(&origin), loop->m_line, loop->m_column
+                ));
+            }
+
+            temporary = declaration.get();
+            temporaries.push_back(temporary);
+            hoisted->statements.push_back(std::move(declaration));
+            ++m_hoistedCount;
+        }
+
+        *candidate = cloneExpression(temporary->identifier.get());
+    }
+
+    hoisted->statements.push_back(std::move(slot));
+    slot = std::move(hoisted);
+}
+
+// Finds the largest invariant subexpressions of `root`. The operands are walked in
+// evaluation order, so that it's known whether something evaluated before an
+// expression may trap.
+void LoopInvariantMover::collectInvariants(ExpressionSlot& root, bool isConditionRoot) {
+    std::unordered_set<const ExpressionNode*> variant;
+    std::vector<std::pair<ExpressionNode*, bool>> nodes{{root.get(), false}};
+
+    // Bottom-up: an expression is variant if any of its operands is
+    while (!nodes.empty()) {
+        auto [node, isExpanded] = nodes.back();
+        nodes.pop_back();
+
+        auto binary = dynamic_cast<BinaryOpNode*>(node);
+        auto element = dynamic_cast<ArrayIndexNode*>(node);
+
+        if (!isExpanded) {
+            nodes.emplace_back(node, true);
+            if (binary) {
+                nodes.emplace_back(binary->left.get(), false);
+                nodes.emplace_back(binary->right.get(), false);
+            } else if (element) {
+                nodes.emplace_back(element->indexExpression.get(), false);
+            }
+            continue;
+        }
+
+        bool isVariant = false;
+
+        if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+            isVariant = m_written.count(identifier->symbolPtr);
+        } else if (binary) {
+            isVariant = variant.count(binary->left.get()) || variant.count(binary->right.get());
+        } else if (element) {
+            isVariant = m_written.count(element->identifier->symbolPtr) || variant.count(element->indexExpression.get());
+        }
+
+        if (isVariant) variant.insert(node);
+    }
+
+    // Top-down: take the outermost invariants, trapping ones only before any other trap of the condition
+    std::vector<std::pair<ExpressionSlot*, bool>> slots{{&root, false}};
+    bool isTrapSeen = false;
+
+    while (!slots.empty()) {
+        auto [slot, isExpanded] = slots.back();
+        slots.pop_back();
+
+        ExpressionNode *node = slot->get();
+        auto binary = dynamic_cast<BinaryOpNode*>(node);
+        auto element = dynamic_cast<ArrayIndexNode*>(node);
+
+        if (isExpanded) {
+            isTrapSeen = isTrapSeen || mayTrapItself(node);
+            continue;
+        }
+
+        if ((binary || element) && !variant.count(node) && isScalarType(node->resolvedType)) {
+            bool isTrapping = mayTrap(node);
+
+            if (!isTrapping || (isConditionRoot && !isTrapSeen)) {
+                m_candidates.push_back(slot);
+                isTrapSeen = isTrapSeen || isTrapping;
+                continue;
+            }
+
+            if (mayTrapItself(node) && Remarks::isEnabled()) {
+                Remarks::missed(*node, std::format(
+                    "cannot hoist invariant `{}` out of loop at {}:{}: it may trap where the loop wouldn't",
+                    expressionText(node), m_loop->m_line, m_loop->m_column
+                ));
+            }
+        }
+
+        slots.emplace_back(slot, true);
+        if (binary) {
+            slots.emplace_back(&binary->right, false);
+            slots.emplace_back(&binary->left, false);
+        } else if (element) {
+            slots.emplace_back(&element->indexExpression, false);
+        }
+    }
+}
@@ -0,0 +1,179 @@
+#include "loop_unroller.hpp"
+#include "arithmetic.hpp"
+#include "constant_folder.hpp"
+#include "remarks.hpp"
+
+#include <format>
+#include <unordered_set>
+
+__extension__ using Int128 = __int128;
+
+namespace {
+
+// Replaces every read of `variable` inside the statement by a constant
+class Substitution : public Traversal {
+public:
+    Substitution(const ExpressionNode& variable, int64_t value) : m_variable(variable), m_value(value) {}
+
+    void apply(ASTNode& node) { traverse(node); }
+
+private:
+    bool preVisit(ASTNode& node) override {
+        forEachExpressionSlot(node, [this](ExpressionSlot& slot) {
+            if (isSameExpression(slot.get(), &m_variable)) {
+                slot = makeConstant(m_value, m_variable.resolvedType, *slot);
+            }
+        });
+
+        return true;
+    }
+
+    const ExpressionNode& m_variable;
+    int64_t m_value;
+};
+
+class NodeCounter : public Traversal {
+public:
+    size_t count(ASTNode& node) {
+        traverse(node);
+        return m_count;
+    }
+
+private:
+    bool preVisit(ASTNode&) override {
+        ++m_count;
+        return true;
+    }
+
+    size_t m_count = 0;
+};
+
+} // namespace
+
+LoopUnroller::LoopUnroller(size_t budget) :
+    m_budget(budget)
+{}
+
+void LoopUnroller::unroll(ASTNode& root) {
+    traverse(root);
+}
+
+size_t LoopUnroller::fullCount() const {
+    return m_fullCount;
+}
+
+size_t LoopUnroller::partialCount() const {
+    return m_partialCount;
+}
+
+// Inner loops are unrolled first
+void LoopUnroller::postVisit(ASTNode& node) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        for (auto& statement : compound->statements) {
+            unrollLoop(statement);
+        }
+    } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        unrollLoop(forNode->body);
+    }
+}
+
+void LoopUnroller::unrollLoop(std::unique_ptr<StatementNode>& slot) {
+    auto loop = dynamic_cast<ForNode*>(slot.get());
+    CountedLoop counted;
+    int64_t first;
+    uint64_t n;
+
+    if (!loop) return;
+
+    if (!matchCountedLoop(*loop, counted) || !countIterations(*loop, counted, first, n)) {
+        Remarks::missed(*loop, "cannot unroll: trip count unknown");
+        return;
+    }
+
+    if (!cloneStatement(loop->body.get())) {
+        Remarks::missed(*loop, "cannot unroll: the body declares an array or a type");
+        return;
+    }
+
+    std::unordered_set<Symbol*> written;
+    collectWrittenSymbols(*loop->body, written);
+    if (written.count(counted.symbol)) {
+        Remarks::missed(*loop, "cannot unroll: the body writes the loop variable");
+        return;
+    }
+
+    // An iteration costs the body and the store of the variable
+    size_t size = NodeCounter().count(*loop->body) + NodeCounter().count(*loop->increment);
+    auto block = std::make_unique<CompoundStatementNode>();
+
+    if (n <= m_budget / size) {
+        block->statements.push_back(std::move(loop->init));
+
+        for (uint64_t i = 0; i < n; ++i) {
+            appendIteration(*block, *loop->body, counted, first + static_cast<int64_t>(i) * counted.step);
+        }
+
+        if (Remarks::isEnabled()) {
+            Remarks::applied(*loop, std::format("fully unrolled loop of {} iteration(s)", n));
+        }
+
+        ConstantFolder().fold(*block);
+        ++m_fullCount;
+    } else {
+        // The main loop and the remainder hold fewer than 2k copies
+        uint64_t k = m_budget / (2 * size);
+        if (k < 2) {
+            if (Remarks::isEnabled()) {
+                Remarks::missed(*loop, std::format("cannot unroll: fewer than 2 copies of a body of {} node(s) fit half the budget of {}",
+                                                     size, m_budget));
+            }
+            return;
+        }
+
+        if (Remarks::isEnabled()) {
+            Remarks::applied(*loop, std::format("unrolled loop of {} iteration(s) by {}", n, k));
+        }
+
+        uint64_t groups = n / k;
+        std::unique_ptr<StatementNode> original = std::move(loop->body);
+        auto body = std::make_unique<CompoundStatementNode>();
+
+        for (uint64_t i = 0; i < k; ++i) {
+            if (i > 0) body->statements.push_back(cloneStatement(loop->increment.get()));
+            body->statements.push_back(cloneStatement(original.get()));
+        }
+
+        // The variable takes the first value of the last group at most
+        auto condition = static_cast<BinaryOpNode*>(loop->condition.get());
+        int64_t mainLast = static_cast<int64_t>(first + static_cast<Int128>(groups - 1) * k * counted.step);
+        condition->op = counted.step > 0 ? ASTNode::OperatorType::LE : ASTNode::OperatorType::GE;
+        condition->right = makeConstant(mainLast, counted.variable->resolvedType, *condition->right);
+
+        loop->body = std::move(body);
+        block->statements.push_back(std::move(slot));
+
+        for (uint64_t i = groups * k; i < n; ++i) {
+            int64_t value = static_cast<int64_t>(first + static_cast<Int128>(i) * counted.step);
+            appendIteration(*block, *original, counted, value);
+        }
+
+        ConstantFolder().fold(*block);
+        ++m_partialCount;
+    }
+
+    slot = std::move(block);
+}
+
+void LoopUnroller::appendIteration(
+    CompoundStatementNode& block, const StatementNode& body, const CountedLoop& counted, int64_t value
+) {
+    auto copy = cloneStatement(&body);
+    Substitution(*counted.variable, value).apply(*copy);
+    block.statements.push_back(std::move(copy));
+
+    const ExpressionNode& variable = *counted.variable;
+    int64_t next = narrowToType(counted.symbol->type, value + counted.step);
+    block.statements.push_back(
+        makeAssignment(cloneExpression(&variable), makeConstant(next, variable.resolvedType, variable), variable)
+    );
+}
@@ -0,0 +1,120 @@
+#include "partial_evaluator.hpp"
+#include "ast_utils.hpp"
+#include "remarks.hpp"
+
+#include <algorithm>
+#include <format>
+#include <sstream>
+#include <unordered_set>
+
+PartialEvaluator::PartialEvaluator(const std::string& filepath, SymbolTable& symbolTable, EvaluationBudget budget) :
+    m_filepath(filepath),
+    m_symbolTable(symbolTable),
+    m_budget(budget)
+{}
+
+size_t PartialEvaluator::evaluatedCount() const {
+    return m_evaluatedCount;
+}
+
+size_t PartialEvaluator::statementCount() const {
+    return m_statementCount;
+}
+
+uint64_t PartialEvaluator::fuelUsed() const {
+    return m_fuelUsed;
+}
+
+void PartialEvaluator::evaluate(ProgramNode& root) {
+    MainDeclNode *main = nullptr;
+    std::vector<ASTNode*> statements;
+    size_t mainStart = 0; // Index of the first statement of main
+
+    // The Interpreter runs the global declarations and main in the order of the source
+    for (auto& declaration : root.declarations) {
+        if (auto mainDecl = dynamic_cast<MainDeclNode*>(declaration.get())) {
+            main = mainDecl;
+            mainStart = statements.size();
+            for (auto& statement : main->body->statements) {
+                statements.push_back(statement.get());
+            }
+        } else {
+            statements.push_back(declaration.get());
+        }
+    }
+
+    if (main == nullptr) return;
+    m_statementCount = statements.size();
+
+    std::ostringstream trace;
+    std::vector<size_t> traceEnds;
+    EvaluationBudget budget = m_budget;
+    Interpreter interpreter(m_filepath, m_symbolTable, trace, &budget);
+
+    for (ASTNode* statement : statements) {
+        try {
+            interpreter.interprete(*statement);
+        } catch (const EvaluationStopped& stopped) {
+            Remarks::missed(*statement, std::string("cannot evaluate at compile time: ") + stopped.reason);
+            break;
+        } catch (const std::runtime_error&) {
+            Remarks::missed(*statement, "cannot evaluate at compile time: it raises a runtime error");
+            break;
+        }
+
+        traceEnds.push_back(static_cast<size_t>(trace.tellp()));
+    }
+
+    m_fuelUsed = m_budget.fuel - budget.fuel;
+
+    // The trace of a global declaration can't be kept before main
+    size_t count = traceEnds.size() < mainStart ? 0 : traceEnds.size();
+    m_evaluatedCount = count;
+
+    // The symbols are left as the completed statements left them, for the actual run
+    if (count < statements.size()) {
+        std::unordered_set<Symbol*> symbols;
+        collectWrittenSymbols(root, symbols);
+
+        for (Symbol* symbol : symbols) {
+            symbol->slot().value = std::monostate{};
+            symbol->slot().arrayValues.clear();
+
+            if (symbol->details().storageType != ASTNode::DataType::UNKNOWN) {
+                symbol->slot().editDetails().packedValues.clear();
+                symbol->slot().editDetails().initializedValues.clear();
+            }
+        }
+
+        std::ostringstream discarded;
+        Interpreter replay(m_filepath, m_symbolTable, discarded);
+
+        for (size_t i = 0; i < count; ++i) {
+            replay.interprete(*statements[i]);
+        }
+    }
+
+    if (count == 0) return;
+
+    if (Remarks::isEnabled()) {
+        Remarks::applied(*main, std::format("evaluated {} of {} statement(s) at compile time", count, statements.size()));
+    }
+
+    std::string text = trace.str().substr(0, traceEnds[count - 1]);
+    if (!text.empty() && text.back() == '\n') text.pop_back();
+
+    // Typedefs have no effect and stay where they are
+    std::erase_if(root.declarations, [&](const auto& declaration) {
+        auto position = std::find(statements.begin(), statements.begin() + count, declaration.get());
+        return position != statements.begin() + count && !dynamic_cast<TypedefNode*>(declaration.get());
+    });
+
+    auto& body = main->body->statements;
+    body.erase(body.begin(), body.begin() + std::min(count - mainStart, body.size()));
+
+    if (!text.empty()) {
+        auto baked = std::make_unique<EmptyStatementNode>(main->m_line, main->m_column);
+        baked->trace = std::move(text);
+        body.insert(body.begin(), std::move(baked));
+    }
+}
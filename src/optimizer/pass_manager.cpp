@@ -0,0 +1,95 @@
+#include "pass_manager.hpp"
+#include "traversal.hpp"
+#include "remarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+PassManager::PassManager(size_t roundBudget) :
+    m_roundBudget(roundBudget)
+{}
+
+void PassManager::add(Pass pass) {
+    m_statistics.push_back(PassStatistics{pass.name});
+    m_passes.push_back(std::move(pass));
+}
+
+bool PassManager::contains(const std::string& name) const {
+    return find(name) != nullptr;
+}
+
+void PassManager::select(unsigned level, const std::vector<std::string>& names) {
+    std::vector<std::string> pending = names;
+
+    for (const Pass& pass : m_passes) {
+        if (pass.level != 0 && pass.level <= level) pending.push_back(pass.name);
+    }
+
+    while (!pending.empty()) {
+        std::string name = std::move(pending.back());
+        pending.pop_back();
+
+        const Pass *pass = find(name);
+        if (pass && m_selected.insert(name).second) {
+            pending.insert(pending.end(), pass->dependencies.begin(), pass->dependencies.end());
+        }
+    }
+}
+
+void PassManager::run() {
+    std::unordered_set<std::string> invalid;
+
+    for (const Pass& pass : m_passes) {
+        if (pass.isIterated && m_selected.count(pass.name)) invalid.insert(pass.name);
+    }
+
+    for (m_roundCount = 0; m_roundCount < m_roundBudget && !invalid.empty(); ++m_roundCount) {
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            const Pass& pass = m_passes[i];
+            if (!pass.isIterated || !invalid.erase(pass.name)) continue;
+
+            size_t changeCount = m_statistics[i].changeCount;
+            execute(i);
+            if (m_statistics[i].changeCount == changeCount) continue;
+
+            for (const std::string& name : pass.invalidates) {
+                const Pass *other = find(name);
+                if (other && other->isIterated && m_selected.count(name)) invalid.insert(name);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        if (!m_passes[i].isIterated && m_selected.count(m_passes[i].name)) execute(i);
+    }
+}
+
+size_t PassManager::roundCount() const {
+    return m_roundCount;
+}
+
+std::vector<PassStatistics> PassManager::statistics() const {
+    std::vector<PassStatistics> statistics;
+    std::copy_if(m_statistics.begin(), m_statistics.end(), std::back_inserter(statistics), [](const PassStatistics& pass) {
+        return pass.runCount > 0;
+    });
+    return statistics;
+}
+
+const Pass* PassManager::find(const std::string& name) const {
+    auto found = std::find_if(m_passes.begin(), m_passes.end(), [&name](const Pass& pass) { return pass.name == name; });
+    return found != m_passes.end() ? &*found : nullptr;
+}
+
+void PassManager::execute(size_t index) {
+    PassStatistics& statistics = m_statistics[index];
+    size_t visitedCount = Traversal::visitedCount();
+    auto start = std::chrono::steady_clock::now();
+
+    Remarks::setPass(m_passes[index].name);
+    statistics.changeCount += m_passes[index].run();
+
+    statistics.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    statistics.visitedCount += Traversal::visitedCount() - visitedCount;
+    ++statistics.runCount;
+}
@@ -0,0 +1,87 @@
+#include "remarks.hpp"
+
+#include <format>
+#include <set>
+#include <tuple>
+
+namespace {
+
+bool isRecording = false;
+std::string currentPass;
+std::vector<Remark> remarks;
+std::set<std::tuple<Remark::Kind, std::string, size_t, size_t, std::string>> recorded;
+
+void record(Remark::Kind kind, const ASTNode& node, const std::string& message) {
+    if (!isRecording) return;
+
+    // Blocks made by the passes have no position of their own, their first statement has
+    const ASTNode *located = &node;
+    while (auto compound = dynamic_cast<const CompoundStatementNode*>(located)) {
+        if (compound->m_line != 0 || compound->statements.empty()) break;
+        located = compound->statements.front().get();
+    }
+
+    size_t line = located->m_line, column = located->m_column;
+    if (!recorded.emplace(kind, currentPass, line, column, message).second) return;
+
+    remarks.push_back(Remark{kind, currentPass, line, column, message});
+}
+
+std::string escape(const std::string& text) {
+    std::string escaped;
+
+    for (char c : text) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) escaped += std::format("\\u{:04x}", static_cast<int>(c));
+                else escaped += c;
+        }
+    }
+
+    return escaped;
+}
+
+} // namespace
+
+void Remarks::enable() {
+    isRecording = true;
+}
+
+bool Remarks::isEnabled() {
+    return isRecording;
+}
+
+void Remarks::setPass(const std::string& name) {
+    currentPass = name;
+}
+
+void Remarks::applied(const ASTNode& node, const std::string& message) {
+    record(Remark::Kind::APPLIED, node, message);
+}
+
+void Remarks::missed(const ASTNode& node, const std::string& message) {
+    record(Remark::Kind::MISSED, node, message);
+}
+
+const std::vector<Remark>& Remarks::all() {
+    return remarks;
+}
+
+void Remarks::write(std::ostream& out) {
+    out << "[";
+
+    for (size_t i = 0; i < remarks.size(); ++i) {
+        const Remark& remark = remarks[i];
+        out << (i ? ",\n " : "\n ") << std::format(
+            R"({{"pass": "{}", "kind": "{}", "line": {}, "column": {}, "message": "{}"}})",
+            escape(remark.pass), remark.kind == Remark::Kind::APPLIED ? "applied" : "missed",
+            remark.line, remark.column, escape(remark.message)
+        );
+    }
+
+    out << (remarks.empty() ? "]\n" : "\n]\n");
+}
@@ -0,0 +1,103 @@
+#include "scalar_replacer.hpp"
+#include "arithmetic.hpp"
+#include "remarks.hpp"
+
+#include <format>
+#include <string>
+
+ScalarReplacer::ScalarReplacer(SymbolTable& symbolTable) :
+    m_symbolTable(symbolTable)
+{}
+
+// The first walk finds the arrays with a variable access, the second replaces the elements of the others
+void ScalarReplacer::replace(ASTNode& root) {
+    m_disqualified.clear();
+    m_elements.clear();
+
+    m_isCollecting = true;
+    traverse(root);
+
+    m_isCollecting = false;
+    traverse(root);
+}
+
+size_t ScalarReplacer::promotedCount() const {
+    return m_promotedCount;
+}
+
+size_t ScalarReplacer::arrayCount() const {
+    return m_arrayCount;
+}
+
+bool ScalarReplacer::preVisit(ASTNode& node) {
+    if (!m_isCollecting) return true;
+
+    if (auto element = dynamic_cast<ArrayIndexNode*>(&node)) {
+        Symbol *array = element->identifier->symbolPtr;
+        int64_t index = 0;
+
+        if (!constantValue(element->indexExpression.get(), index) || index < 0 || index >= array->arraySize) {
+            m_disqualified.insert(array);
+
+            if (Remarks::isEnabled()) {
+                Remarks::missed(*element, std::format(
+                    "cannot promote the elements of `{}`: `{}` isn't a constant index within bounds",
+                    element->identifier->name, expressionText(element->indexExpression.get())
+                ));
+            }
+        }
+
+        // The index can access other arrays
+        return true;
+    }
+
+    // An array used whole can't be taken apart
+    forEachExpressionSlot(node, [this](ExpressionSlot& slot) {
+        auto identifier = dynamic_cast<IdentifierNode*>(slot.get());
+        if (identifier && identifier->symbolPtr->isArray) {
+            m_disqualified.insert(identifier->symbolPtr);
+
+            if (Remarks::isEnabled()) {
+                Remarks::missed(*identifier, std::format("cannot promote the elements of `{}`: it's used whole", identifier->name));
+            }
+        }
+    });
+
+    return true;
+}
+
+void ScalarReplacer::postVisit(ASTNode& node) {
+    if (m_isCollecting) return;
+
+    forEachExpressionSlot(node, [this](ExpressionSlot& slot) {
+        auto element = dynamic_cast<ArrayIndexNode*>(slot.get());
+        if (element == nullptr || m_disqualified.count(element->identifier->symbolPtr)) return;
+
+        // Every access to an array which isn't disqualified has a constant index
+        int64_t index;
+        if (!constantValue(element->indexExpression.get(), index)) return;
+
+        std::string name = element->identifier->name + "[" + std::to_string(index) + "]";
+        if (Remarks::isEnabled()) Remarks::applied(*element, std::format("promoted `{}` to a scalar", name));
+
+        slot = makeIdentifier(elementSymbol(element->identifier->symbolPtr, index), name, *element);
+    });
+}
+
+Symbol* ScalarReplacer::elementSymbol(Symbol* array, int64_t index) {
+    auto found = m_elements.find({array, index});
+    if (found != m_elements.end()) return found->second;
+
+    Symbol newSymbol;
+    newSymbol.type = array->type;
+    newSymbol.declarationNode = array->declarationNode;
+    newSymbol.editDetails().elementOf = array;
+    newSymbol.editDetails().elementIndex = index;
+
+    Symbol *symbol = m_symbolTable.createAnonymous(std::move(newSymbol));
+    if (array->details().promotedElements.empty()) ++m_arrayCount;
+    array->editDetails().promotedElements.push_back(symbol);
+    ++m_promotedCount;
+
+    return m_elements[{array, index}] = symbol;
+}
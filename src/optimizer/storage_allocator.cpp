@@ -0,0 +1,130 @@
+#include "storage_allocator.hpp"
+#include "remarks.hpp"
+
+#include <format>
+#include <map>
+#include <queue>
+#include <utility>
+
+void StorageAllocator::allocate(ASTNode& root) {
+    m_position = 0;
+    m_mainBody = nullptr;
+    m_frames.clear();
+    m_lifetimes.clear();
+    m_lifetimeOf.clear();
+    m_ends.clear();
+
+    traverse(root);
+
+    for (Lifetime& lifetime : m_lifetimes) {
+        lifetime.last = m_ends[lifetime.lastStatement];
+    }
+
+    m_declarationCount = m_lifetimes.size();
+    assignSlots(false);
+    assignSlots(true);
+}
+
+size_t StorageAllocator::declarationCount() const {
+    return m_declarationCount;
+}
+
+size_t StorageAllocator::slotCount() const {
+    return m_slotCount;
+}
+
+bool StorageAllocator::preVisit(ASTNode& node) {
+    ++m_position;
+
+    if (auto main = dynamic_cast<MainDeclNode*>(&node)) {
+        m_mainBody = main->body.get();
+    } else if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        m_frames.push_back({compound});
+    } else if (auto varDecl = dynamic_cast<VariableDeclNode*>(&node)) {
+        declare(*varDecl->identifier);
+    } else if (auto arrayDecl = dynamic_cast<ArrayDeclNode*>(&node)) {
+        declare(*arrayDecl->identifier);
+    } else if (auto identifier = dynamic_cast<IdentifierNode*>(&node)) {
+        // A use keeps the variable alive until the end of the statement of its block which contains it
+        auto found = m_lifetimeOf.find(identifier->symbolPtr);
+        if (found == m_lifetimeOf.end()) return true;
+
+        Lifetime& lifetime = m_lifetimes[found->second];
+        if (lifetime.depth < m_frames.size() && m_frames[lifetime.depth].compound != m_mainBody) {
+            lifetime.lastStatement = m_frames[lifetime.depth].statement;
+        }
+    }
+
+    return true;
+}
+
+ASTNode* StorageAllocator::nextChild(ASTNode& node, size_t& step) {
+    ASTNode *child = Traversal::nextChild(node, step);
+    if (!m_frames.empty() && m_frames.back().compound == &node) m_frames.back().statement = child;
+    return child;
+}
+
+void StorageAllocator::postVisit(ASTNode& node) {
+    if (!m_frames.empty() && m_frames.back().compound == &node) {
+        m_ends[&node] = m_position;
+        m_frames.pop_back();
+    }
+
+    if (!m_frames.empty() && m_frames.back().statement == &node) m_ends[&node] = m_position;
+}
+
+// Globals, typedef-names and promoted elements keep storage of their own
+void StorageAllocator::declare(const IdentifierNode& identifier) {
+    Symbol *symbol = identifier.symbolPtr;
+    if (symbol == nullptr || symbol->isTypedef || symbol->details().elementOf || m_frames.empty()) return;
+
+    const Frame& frame = m_frames.back();
+    ASTNode *lastStatement = frame.compound == m_mainBody ? frame.compound : frame.statement;
+
+    // An unrolled body declares the same symbol again further on
+    auto [found, isInserted] = m_lifetimeOf.try_emplace(symbol, m_lifetimes.size());
+    if (isInserted) {
+        m_lifetimes.push_back({symbol, &identifier, m_position, m_frames.size() - 1, lastStatement});
+    } else {
+        m_lifetimes[found->second].depth = m_frames.size() - 1;
+        m_lifetimes[found->second].lastStatement = lastStatement;
+    }
+}
+
+// Linear scan over the lifetimes, which are recorded in the order they start.
+// Arrays only share a slot with arrays of the same storage type
+void StorageAllocator::assignSlots(bool isArray) {
+    using Active = std::pair<size_t, Symbol*>; // End of the lifetime and the owner of its slot
+    std::priority_queue<Active, std::vector<Active>, std::greater<Active>> active;
+    std::map<ASTNode::DataType, std::vector<Symbol*>> freeSlots;
+
+    for (const Lifetime& lifetime : m_lifetimes) {
+        if (lifetime.symbol->isArray != isArray) continue;
+
+        while (!active.empty() && active.top().first < lifetime.first) {
+            freeSlots[active.top().second->details().storageType].push_back(active.top().second);
+            active.pop();
+        }
+
+        Symbol *owner = lifetime.symbol;
+        std::vector<Symbol*>& candidates = freeSlots[lifetime.symbol->details().storageType];
+
+        if (!candidates.empty()) {
+            owner = candidates.back();
+            candidates.pop_back();
+        } else {
+            ++m_slotCount;
+        }
+
+        lifetime.symbol->slotOwner = owner == lifetime.symbol ? nullptr : owner;
+
+        if (owner != lifetime.symbol && Remarks::isEnabled()) {
+            const IdentifierNode& ownerDeclaration = *m_lifetimes[m_lifetimeOf[owner]].declaration;
+            Remarks::applied(*lifetime.declaration, std::format(
+                "`{}` shares the storage of `{}` declared at {}:{}", lifetime.declaration->name,
+                ownerDeclaration.name, ownerDeclaration.m_line, ownerDeclaration.m_column
+            ));
+        }
+        active.emplace(lifetime.last, owner);
+    }
+}
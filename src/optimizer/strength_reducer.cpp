@@ -0,0 +1,242 @@
+#include "strength_reducer.hpp"
+#include "arithmetic.hpp"
+#include "remarks.hpp"
+
+#include <bit>
+#include <format>
+#include <vector>
+
+using OperatorType = ASTNode::OperatorType;
+
+namespace {
+
+// Products i * stride of the same stride and type, rewritten to one temporary
+struct InductionGroup {
+    const IdentifierNode *stride; // nullptr for a constant stride
+    int64_t strideValue;
+    ASTNode::DataType type;
+    std::vector<ExpressionSlot*> occurrences;
+};
+
+bool isIdentifierOf(const ExpressionNode* node, const Symbol* symbol) {
+    auto identifier = dynamic_cast<const IdentifierNode*>(node);
+    return identifier && identifier->symbolPtr == symbol;
+}
+
+// Collects the products of the loop variable with a value which doesn't change in the loop
+class ProductCollector : public Traversal {
+public:
+    ProductCollector(const Symbol* variable, const std::unordered_set<Symbol*>& written, std::vector<InductionGroup>& groups) :
+        m_variable(variable),
+        m_written(written),
+        m_groups(groups)
+    {}
+
+    void collect(ASTNode& node) { traverse(node); }
+
+private:
+    void postVisit(ASTNode& node) override {
+        forEachExpressionSlot(node, [this](ExpressionSlot& slot) {
+            auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+            if (!binary || binary->op != OperatorType::MULT) return;
+
+            const ExpressionNode *stride;
+            if (isIdentifierOf(binary->left.get(), m_variable)) stride = binary->right.get();
+            else if (isIdentifierOf(binary->right.get(), m_variable)) stride = binary->left.get();
+            else return;
+
+            auto strideName = dynamic_cast<const IdentifierNode*>(stride);
+            int64_t strideValue = 0;
+
+            if (strideName) {
+                Symbol *symbol = strideName->symbolPtr;
+                // The first product is computed before the loop, where reading the stride mustn't fail
+                if (symbol == m_variable || m_written.count(symbol) || mayTrapItself(strideName)) return;
+            } else if (!constantValue(stride, strideValue)) {
+                return;
+            }
+
+            for (InductionGroup& group : m_groups) {
+                bool isSameStride = strideName
+                    ? group.stride && group.stride->symbolPtr == strideName->symbolPtr
+                    : !group.stride && group.strideValue == strideValue;
+
+                if (isSameStride && group.type == binary->resolvedType) {
+                    group.occurrences.push_back(&slot);
+                    return;
+                }
+            }
+
+            m_groups.push_back(InductionGroup{strideName, strideValue, binary->resolvedType, {&slot}});
+        });
+    }
+
+    const Symbol *m_variable;
+    const std::unordered_set<Symbol*>& m_written;
+    std::vector<InductionGroup>& m_groups;
+};
+
+} // namespace
+
+StrengthReducer::StrengthReducer(SymbolTable& symbolTable) :
+    m_symbolTable(symbolTable)
+{}
+
+void StrengthReducer::reduce(ASTNode& root) {
+    markInitializedReads(root);
+    traverse(root);
+}
+
+size_t StrengthReducer::inductionCount() const {
+    return m_inductionCount;
+}
+
+size_t StrengthReducer::shiftCount() const {
+    return m_shiftCount;
+}
+
+size_t StrengthReducer::divisionCount() const {
+    return m_divisionCount;
+}
+
+// Loops are rewritten before their bodies are visited, so nested loops are reduced too
+bool StrengthReducer::preVisit(ASTNode& node) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        for (auto& statement : compound->statements) {
+            reduceInduction(statement);
+        }
+    } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        reduceInduction(forNode->body);
+    }
+
+    return true;
+}
+
+void StrengthReducer::postVisit(ASTNode& node) {
+    forEachExpressionSlot(node, [this](ExpressionSlot& slot) {
+        auto binary = dynamic_cast<BinaryOpNode*>(slot.get());
+        if (binary == nullptr) return;
+
+        int64_t value;
+        if (!constantValue(binary->right.get(), value)) return;
+
+        // x * 2^k -> x << k, equal modulo 2^64 before the result is narrowed
+        if (binary->op == OperatorType::MULT && value > 1 && std::has_single_bit(static_cast<uint64_t>(value))) {
+            if (Remarks::isEnabled()) {
+                Remarks::applied(*binary, std::format("replaced `{}` by a shift", expressionText(binary)));
+            }
+
+            auto amount = makeConstant(std::countr_zero(static_cast<uint64_t>(value)), ASTNode::DataType::INT, *binary->right);
+            slot = makeBinary(OperatorType::BLS, std::move(binary->left), std::move(amount), binary->resolvedType, *binary);
+            ++m_shiftCount;
+            return;
+        }
+
+        if ((binary->op == OperatorType::DIV || binary->op == OperatorType::MOD) && !binary->divisionPlan) {
+            DivisionPlan plan;
+            if (!planDivision(value, plan)) {
+                if (Remarks::isEnabled()) {
+                    Remarks::missed(*binary, std::format("cannot reduce `{}`: no cheaper sequence for the divisor", expressionText(binary)));
+                }
+                return;
+            }
+
+            if (Remarks::isEnabled()) {
+                Remarks::applied(*binary, std::format(
+                    "replaced `{}` by {}", expressionText(binary), plan.isPowerOfTwo ? "a shift" : "a multiplication"
+                ));
+            }
+
+            binary->divisionPlan = plan;
+            ++m_divisionCount;
+        }
+    });
+}
+
+// { init; T t = i * s; for (; cond; inc) { body[i * s := t]; t = t + s * step; } }
+void StrengthReducer::reduceInduction(std::unique_ptr<StatementNode>& slot) {
+    auto loop = dynamic_cast<ForNode*>(slot.get());
+    CountedLoop counted;
+
+    // The temporary is initialized before the loop, which must run for it to be read
+    if (!loop || !matchCountedLoop(*loop, counted) || !runsAtLeastOnce(*loop)) return;
+
+    // Element variables aren't reduced, the products are searched by symbol
+    auto variable = dynamic_cast<IdentifierNode*>(counted.variable);
+    if (variable == nullptr || counted.step > INT32_MAX || counted.step < -INT32_MAX) return;
+
+    std::unordered_set<Symbol*> written;
+    collectWrittenSymbols(*loop->body, written);
+    if (written.count(variable->symbolPtr)) return;
+
+    std::vector<InductionGroup> groups;
+    ProductCollector(variable->symbolPtr, written, groups).collect(*loop->body);
+    if (groups.empty()) return;
+
+    auto reduced = std::make_unique<CompoundStatementNode>();
+    if (loop->init) reduced->statements.push_back(std::move(loop->init));
+
+    std::vector<std::unique_ptr<StatementNode>> updates;
+
+    for (InductionGroup& group : groups) {
+        const ExpressionNode& origin = **group.occurrences.front();
+
+        if (Remarks::isEnabled()) {
+            Remarks::applied(origin, std::format(
+                "replaced {} occurrence(s) of `{}` by an induction variable of loop at {}:{}",
+                group.occurrences.size(), expressionText(&origin), loop->m_line, loop->m_column
+            ));
+        }
+
+        auto temporary = declareTemporary(m_symbolTable, "sr", group.type, cloneExpression(&origin), origin);
+        IdentifierNode& name = *temporary->identifier;
+
+        // The temporary moves by s * step in every iteration
+        ExpressionSlot increment;
+
+        if (group.stride) {
+            if (counted.step == 1) {
+                increment = cloneExpression(group.stride);
+            } else {
+                auto product = makeBinary(
+                    OperatorType::MULT, cloneExpression(group.stride), makeConstant(counted.step, group.type, origin),
+                    group.type, origin
+                );
+                auto stepTemporary = declareTemporary(m_symbolTable, "sr", group.type, std::move(product), origin);
+                increment = cloneExpression(stepTemporary->identifier.get());
+                reduced->statements.push_back(std::move(stepTemporary));
+            }
+        } else {
+            int64_t value;
+            evaluateOperator(OperatorType::MULT, group.strideValue, counted.step, group.type, value);
+            increment = makeConstant(value, group.type, origin);
+        }
+
+        auto sum = makeBinary(OperatorType::ADD, cloneExpression(&name), std::move(increment), group.type, origin);
+        updates.push_back(makeAssignment(cloneExpression(&name), std::move(sum), origin));
+        reduced->statements.push_back(std::move(temporary));
+
+        for (ExpressionSlot* occurrence : group.occurrences) {
+            *occurrence = cloneExpression(&name);
+        }
+
+        ++m_inductionCount;
+    }
+
+    // The updates run last in every iteration; the language has no break or continue
+    auto body = dynamic_cast<CompoundStatementNode*>(loop->body.get());
+
+    if (body == nullptr) {
+        auto wrapper = std::make_unique<CompoundStatementNode>();
+        wrapper->statements.push_back(std::move(loop->body));
+        body = wrapper.get();
+        loop->body = std::move(wrapper);
+    }
+
+    for (auto& update : updates) {
+        body->statements.push_back(std::move(update));
+    }
+
+    reduced->statements.push_back(std::move(slot));
+    slot = std::move(reduced);
+}
@@ -0,0 +1,49 @@
+#include "update_fuser.hpp"
+#include "remarks.hpp"
+
+#include <format>
+
+void UpdateFuser::fuse(ASTNode& root) {
+    traverse(root);
+}
+
+size_t UpdateFuser::fusedCount() const {
+    return m_fusedCount;
+}
+
+void UpdateFuser::postVisit(ASTNode& node) {
+    if (auto compound = dynamic_cast<CompoundStatementNode*>(&node)) {
+        for (auto& statement : compound->statements) {
+            fuseStatement(statement);
+        }
+    } else if (auto forNode = dynamic_cast<ForNode*>(&node)) {
+        fuseStatement(forNode->init);
+        fuseStatement(forNode->increment);
+        fuseStatement(forNode->body);
+    }
+}
+
+template<typename Statement>
+void UpdateFuser::fuseStatement(std::unique_ptr<Statement>& slot) {
+    auto assignment = dynamic_cast<AssignmentNode*>(slot.get());
+    if (!assignment || dynamic_cast<UpdateNode*>(assignment)) return;
+
+    auto operation = dynamic_cast<BinaryOpNode*>(assignment->right.get());
+    if (!operation || !isSameExpression(operation->left.get(), assignment->left.get())) return;
+
+    // A whole array can't be a target, only its elements
+    auto identifier = dynamic_cast<IdentifierNode*>(assignment->left.get());
+    if (identifier ? identifier->symbolPtr->isArray : !dynamic_cast<ArrayIndexNode*>(assignment->left.get())) return;
+
+    if (Remarks::isEnabled()) {
+        Remarks::applied(*assignment, std::format(
+            "fused `{} = {}` into an in-place update", expressionText(assignment->left.get()), expressionText(operation)
+        ));
+    }
+
+    auto update = std::make_unique<UpdateNode>(assignment->m_line, assignment->m_column);
+    update->left = std::move(assignment->left);
+    update->right = std::move(assignment->right);
+    slot = std::move(update);
+    ++m_fusedCount;
+}
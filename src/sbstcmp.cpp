@@ -3,8 +3,282 @@
 #include "analyzer.hpp"
 #include "ast_printer.hpp"
 #include "interpreter.hpp"
+#include "constant_folder.hpp"
+#include "algebraic_simplifier.hpp"
+#include "closed_form_evaluator.hpp"
+#include "loop_fuser.hpp"
+#include "loop_unroller.hpp"
+#include "scalar_replacer.hpp"
+#include "loop_invariant_mover.hpp"
+#include "strength_reducer.hpp"
+#include "update_fuser.hpp"
+#include "copy_propagator.hpp"
+#include "dead_code_eliminator.hpp"
+#include "dead_store_eliminator.hpp"
+#include "bounds_check_eliminator.hpp"
+#include "storage_allocator.hpp"
+#include "partial_evaluator.hpp"
+#include "ir_builder.hpp"
+#include "ir_verifier.hpp"
+#include "ir_printer.hpp"
+#include "conditional_constant_propagator.hpp"
+#include "pass_manager.hpp"
+#include "remarks.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+
+struct OptimizerOptions {
+    bool isVerbose = false;
+    size_t unrollBudget = 64;
+    EvaluationBudget evaluationBudget{1'000'000, 1 << 20};
+    std::vector<std::string> simplifierRules;
+};
+
+// The AST passes in the order they run. -O1 only cleans up the tree, -O2 also
+// restructures loops and evaluates what it can; the cleanups run again after
+// any pass which leaves something for them.
+static void registerPasses(PassManager& manager, ProgramNode& root, SymbolTable& table, const std::string& filepath,
+    const OptimizerOptions& options)
+{
+    bool isVerbose = options.isVerbose;
+
+    manager.add({"fold", 1, {}, {"simplify", "closed-form", "dce"}, true, [&root, isVerbose]() -> size_t {
+        ConstantFolder folder;
+        folder.fold(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: constant folding: " << folder.foldedCount() << " node(s) folded" << std::endl;
+        }
+
+        return folder.foldedCount();
+    }});
+
+    manager.add({"simplify", 1, {}, {"fold", "dce"}, true, [&root, &options, isVerbose]() -> size_t {
+        AlgebraicSimplifier simplifier(options.simplifierRules);
+        simplifier.simplify(root);
+        size_t rewriteCount = 0;
+
+        for (const auto& rule : AlgebraicSimplifier::rules()) {
+            size_t count = simplifier.rewriteCount(rule.name);
+            if (count && isVerbose) std::cout << "[Optimizer]: " << rule.name << ": " << count << " rewrite(s)" << std::endl;
+            rewriteCount += count;
+        }
+
+        return rewriteCount;
+    }});
+
+    manager.add({"closed-form", 2, {}, {"fold", "dce"}, true, [&root, isVerbose]() -> size_t {
+        ClosedFormEvaluator closedForm;
+        closedForm.evaluate(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: closed-form evaluation: " << closedForm.replacedCount() << " loop(s) replaced" << std::endl;
+        }
+
+        return closedForm.replacedCount();
+    }});
+
+    manager.add({"fuse", 2, {}, {"dce"}, true, [&root, isVerbose]() -> size_t {
+        LoopFuser fuser;
+        fuser.fuse(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: loop fusion: " << fuser.fusedCount() << " loop(s) fused" << std::endl;
+        }
+
+        return fuser.fusedCount();
+    }});
+
+    manager.add({"unroll", 2, {}, {"fold", "simplify", "sra", "copy-prop", "dce"}, true, [&root, &options, isVerbose]() -> size_t {
+        LoopUnroller unroller(options.unrollBudget);
+        unroller.unroll(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: loop unrolling: " << unroller.fullCount() << " loop(s) fully unrolled, "
+                << unroller.partialCount() << " partially" << std::endl;
+        }
+
+        return unroller.fullCount() + unroller.partialCount();
+    }});
+
+    manager.add({"sra", 2, {}, {"copy-prop", "dce"}, true, [&root, &table, isVerbose]() -> size_t {
+        ScalarReplacer scalarReplacer(table);
+        scalarReplacer.replace(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: scalar replacement: " << scalarReplacer.promotedCount() << " element(s) of "
+                << scalarReplacer.arrayCount() << " array(s) promoted" << std::endl;
+        }
+
+        return scalarReplacer.promotedCount();
+    }});
+
+    manager.add({"licm", 2, {}, {"copy-prop", "dce"}, true, [&root, &table, isVerbose]() -> size_t {
+        LoopInvariantMover mover(table);
+        mover.hoist(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: loop-invariant code motion: " << mover.hoistedCount() << " expression(s) hoisted" << std::endl;
+        }
+
+        return mover.hoistedCount();
+    }});
+
+    manager.add({"strength-reduce", 2, {}, {"dce"}, true, [&root, &table, isVerbose]() -> size_t {
+        StrengthReducer reducer(table);
+        reducer.reduce(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: strength reduction: " << reducer.inductionCount() << " induction product(s), "
+                << reducer.shiftCount() << " shift(s), " << reducer.divisionCount() << " division(s)" << std::endl;
+        }
+
+        return reducer.inductionCount() + reducer.shiftCount() + reducer.divisionCount();
+    }});
+
+    manager.add({"copy-prop", 1, {}, {"fold", "simplify", "dce", "dse"}, true, [&root, &table, isVerbose]() -> size_t {
+        CopyPropagator copyPropagator(table);
+        copyPropagator.propagate(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: copy propagation: " << copyPropagator.propagatedCount() << " read(s) propagated, "
+                << copyPropagator.eliminatedLoadCount() << " load(s) eliminated" << std::endl;
+        }
+
+        return copyPropagator.propagatedCount() + copyPropagator.eliminatedLoadCount();
+    }});
+
+    manager.add({"dce", 1, {}, {"copy-prop", "dse"}, true, [&root, isVerbose]() -> size_t {
+        DeadCodeEliminator eliminator;
+        eliminator.eliminate(root);
+        const DeadCodeReport& report = eliminator.report();
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: dead code elimination: " << report.emptyStatements << " empty statement(s), "
+                << report.emptyBlocks << " empty block(s), " << report.unreachableStatements << " unreachable statement(s), "
+                << report.unusedDeclarations << " unused declaration(s), " << report.deadStores << " dead store(s)" << std::endl;
+        }
+
+        return report.emptyStatements + report.emptyBlocks + report.unreachableStatements + report.unusedDeclarations
+            + report.deadStores;
+    }});
+
+    manager.add({"dse", 1, {}, {"dce"}, true, [&root, isVerbose]() -> size_t {
+        DeadStoreEliminator storeEliminator;
+        storeEliminator.eliminate(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: dead store elimination: " << storeEliminator.removedCount() << " store(s) removed" << std::endl;
+        }
+
+        return storeEliminator.removedCount();
+    }});
+
+    // Narrowing reads the values the bounds check elimination saw stored
+    auto boundsEliminator = std::make_shared<BoundsCheckEliminator>(filepath);
+
+    manager.add({"bce", 1, {}, {}, false, [&root, boundsEliminator, isVerbose]() -> size_t {
+        boundsEliminator->eliminate(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: bounds check elimination: " << boundsEliminator->eliminatedCount() << " check(s) removed, "
+                << boundsEliminator->failingCount() << " access(es) out of bounds" << std::endl;
+        }
+
+        return boundsEliminator->eliminatedCount();
+    }});
+
+    manager.add({"narrow-arrays", 0, {"bce"}, {}, false, [boundsEliminator, isVerbose]() -> size_t {
+        size_t narrowedCount = boundsEliminator->narrowArrays();
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: array narrowing: " << narrowedCount << " array(s) narrowed" << std::endl;
+        }
+
+        return narrowedCount;
+    }});
+
+    manager.add({"storage", 2, {}, {}, false, [&root, isVerbose]() -> size_t {
+        StorageAllocator storageAllocator;
+        storageAllocator.allocate(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: storage allocation: " << storageAllocator.declarationCount() << " variable(s) in "
+                << storageAllocator.slotCount() << " slot(s)" << std::endl;
+        }
+
+        return storageAllocator.declarationCount() - storageAllocator.slotCount();
+    }});
+
+    manager.add({"partial-eval", 2, {}, {}, false, [&root, &table, &filepath, &options, isVerbose]() -> size_t {
+        PartialEvaluator partialEvaluator(filepath, table, options.evaluationBudget);
+        partialEvaluator.evaluate(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: partial evaluation: " << partialEvaluator.evaluatedCount() << " of "
+                << partialEvaluator.statementCount() << " statement(s) evaluated, " << partialEvaluator.fuelUsed()
+                << " fuel used" << std::endl;
+        }
+
+        return partialEvaluator.evaluatedCount();
+    }});
+
+    // Last, the updates only change how the Interpreter stores
+    manager.add({"fuse-updates", 1, {}, {}, false, [&root, isVerbose]() -> size_t {
+        UpdateFuser updateFuser;
+        updateFuser.fuse(root);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: read-modify-write fusion: " << updateFuser.fusedCount() << " assignment(s) fused" << std::endl;
+        }
+
+        return updateFuser.fusedCount();
+    }});
+}
+
+// The IR passes, run on the function once it is lowered
+static void registerIRPasses(PassManager& manager, std::unique_ptr<IRFunction>& function, bool isVerbose) {
+    manager.add({"sccp", 1, {}, {}, true, [&function, isVerbose]() -> size_t {
+        ConditionalConstantPropagator propagator;
+        propagator.run(*function);
+
+        if (isVerbose) {
+            std::cout << "[Optimizer]: sparse conditional constant propagation: " << propagator.constantCount()
+                << " constant(s), " << propagator.foldedBranchCount() << " branch(es) folded, "
+                << propagator.removedBlockCount() << " block(s) removed" << std::endl;
+        }
+
+        IRVerifier verifier;
+        if (!verifier.verify(*function)) {
+            std::cerr << "[ERROR]: IR verification failed after constant propagation: " << verifier.errors().front() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        return propagator.constantCount() + propagator.foldedBranchCount() + propagator.removedBlockCount();
+    }});
+}
+
+static void printStatistics(const PassManager& manager) {
+    for (const PassStatistics& pass : manager.statistics()) {
+        std::cout << std::format("[Optimizer]: pass {}: {} run(s), {:.3f} ms, {} node(s) visited, {} change(s)",
+            pass.name, pass.runCount, pass.milliseconds, pass.visitedCount, pass.changeCount) << std::endl;
+    }
+}
+
+// Reads the unsigned number after the '=' of an option, all of it
+template<typename Number>
+static bool parseNumber(const std::string& arg, Number& value) {
+    const char *begin = arg.data() + arg.find('=') + 1;
+    const char *end = arg.data() + arg.size();
+    auto [last, error] = std::from_chars(begin, end, value);
+    return error == std::errc() && last == end;
+}
 
 int main(int argc, char *argv[]) {
     if (argc == 1) {
@@ -14,16 +288,75 @@ int main(int argc, char *argv[]) {
 
     bool displayTree = false;
     bool isInterpretationEnabled = false;
+    bool isVerbose = false;
+    bool isIREmitted = false;
+    unsigned optimizationLevel = 0;
+    size_t passRounds = 4;
+    std::vector<std::string> passNames;
+    std::string remarksPath;
+    bool isArrayNarrowingEnabled = false;
+    size_t jobs = 1;
+    OptimizerOptions options;
     std::string filepath;
 
     for (int i = 1; i < argc; ++i) {
         auto arg = std::string(argv[i]);
+        bool isValid = true;
 
         if (arg == "-T") displayTree = true;
+        else if (arg == "-O") optimizationLevel = 2;
+        else if (arg == "-O0" || arg == "-O1" || arg == "-O2") optimizationLevel = arg[2] - '0';
+        else if (arg == "-v") options.isVerbose = isVerbose = true;
         else if (arg == "--int") isInterpretationEnabled = true;
+        else if (arg == "--emit-ir") isIREmitted = true;
+        else if (arg == "--narrow-arrays") isArrayNarrowingEnabled = true;
+        else if (arg.starts_with("--jobs=")) isValid = parseNumber(arg, jobs) && jobs > 0;
+        else if (arg.starts_with("--unroll-budget=")) isValid = parseNumber(arg, options.unrollBudget);
+        else if (arg.starts_with("--fuel=")) isValid = parseNumber(arg, options.evaluationBudget.fuel);
+        else if (arg.starts_with("--eval-memory=")) isValid = parseNumber(arg, options.evaluationBudget.memory);
+        else if (arg.starts_with("--pass-rounds=")) isValid = parseNumber(arg, passRounds);
+        else if (arg.starts_with("--remarks=")) remarksPath = arg.substr(10);
+        else if (arg.starts_with("--rules=")) {
+            std::istringstream list(arg.substr(8));
+            for (std::string rule; std::getline(list, rule, ',');) {
+                const auto& rules = AlgebraicSimplifier::rules();
+                bool isKnown = std::any_of(rules.begin(), rules.end(), [&rule](const RewriteRule& known) {
+                    return known.name == rule;
+                });
+
+                if (!isKnown) {
+                    std::cerr << "[ERROR]: Unknown rule '" << rule << "'." << std::endl;
+                    return 1;
+                }
+
+                options.simplifierRules.push_back(rule);
+            }
+        }
+        else if (arg.starts_with("--passes=")) {
+            std::istringstream list(arg.substr(9));
+            for (std::string pass; std::getline(list, pass, ',');) passNames.push_back(pass);
+        }
+        else if (arg.starts_with("-")) {
+            std::cerr << "[ERROR]: Unknown option '" << arg << "'." << std::endl;
+            return 1;
+        }
         else filepath = arg; 
+
+        if (!isValid) {
+            std::cerr << "[ERROR]: Invalid value in '" << arg << "'." << std::endl;
+            return 1;
+        }
     }
 
+    // Narrowing is an addition to the optimized pipeline, not a pipeline of its own
+    if (isArrayNarrowingEnabled && optimizationLevel > 0) passNames.push_back("narrow-arrays");
+    if (!remarksPath.empty()) Remarks::enable();
+
+    std::unique_ptr<IRFunction> function;
+    PassManager passManager(optimizationLevel == 1 ? 1 : passRounds);
+    PassManager irPassManager(1);
+    registerIRPasses(irPassManager, function, isVerbose);
+
     Lexer lexer(filepath);
     
     Parser parser(lexer);
@@ -34,9 +367,58 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    Analyzer analyzer(filepath);
+    Analyzer analyzer(filepath, jobs);
     SymbolTable& table = analyzer.analyze(*root);
 
+    registerPasses(passManager, *root, table, filepath, options);
+
+    for (const std::string& name : passNames) {
+        if (!passManager.contains(name) && !irPassManager.contains(name)) {
+            std::cerr << "[ERROR]: Unknown pass '" << name << "'." << std::endl;
+            return 1;
+        }
+    }
+
+    passManager.select(optimizationLevel, passNames);
+    passManager.run();
+
+    if (isVerbose) {
+        std::cout << "[Optimizer]: pass manager: " << passManager.roundCount() << " round(s)" << std::endl;
+        printStatistics(passManager);
+    }
+
+    if (!remarksPath.empty()) {
+        std::ofstream remarks(remarksPath);
+
+        if (!remarks) {
+            std::cerr << "[ERROR]: Couldn't open the remarks file '" << remarksPath << "'." << std::endl;
+            return 1;
+        }
+
+        Remarks::write(remarks);
+    }
+
+    // Naming an IR pass lowers the program even when the IR isn't printed
+    bool isIRBuilt = isIREmitted || std::any_of(passNames.begin(), passNames.end(), [&irPassManager](const std::string& name) {
+        return irPassManager.contains(name);
+    });
+
+    if (isIRBuilt) {
+        function = IRBuilder().build(*root);
+        IRVerifier verifier;
+
+        if (!verifier.verify(*function)) {
+            std::cerr << "[ERROR]: IR verification failed after lowering: " << verifier.errors().front() << std::endl;
+            return 1;
+        }
+
+        irPassManager.select(optimizationLevel, passNames);
+        irPassManager.run();
+
+        if (isVerbose) printStatistics(irPassManager);
+        if (isIREmitted) IRPrinter(std::cout).print(*function);
+    }
+
     if (displayTree) {
         ASTPrinter printer;
         printer.print(*root);
@@ -0,0 +1,4 @@
+int main() {
+    int a[3] = {1, 2, 3}, i;
+    for (i = 0; i < 4; i = i + 1) a[i] = i;
+}
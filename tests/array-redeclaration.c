@@ -0,0 +1,8 @@
+int main() {
+    int s = 0, i;
+    for (i = 0; i < 3; i = i + 1) {
+        int b[6] = {2, 3};
+        s = s + b[1] + b[5];
+        b[5] = 7;
+    }
+}
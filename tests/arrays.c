@@ -0,0 +1,7 @@
+int main() {
+    char text[6] = "hi";
+    long v[4] = {7, -1};
+    int i;
+    for (i = 0; i < 3; i = i + 1) v[i + 1] = v[i] * 2;
+    text[1] = text[0] + 1;
+}
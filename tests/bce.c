@@ -0,0 +1,5 @@
+int main() {
+    int a[4], i;
+    for (i = 0; i < 4; i = i + 1) a[i] = i;
+    a[42] = 5;
+}
@@ -0,0 +1,7 @@
+int main() {
+    long s = 0, t = 0, u = 0;
+    int i, arr[1];
+    for (arr[0] = 2; arr[0] > 0; arr[0] = arr[0] - 1) s = s + arr[0] * 3 + 1;
+    for (i = 0; i < 10; i = i + 1) t = t + i * 200000000 + 1;
+    for (i = 0; i < 4; i = i + 1) u = u + i * 1000000000;
+}
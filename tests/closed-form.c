@@ -0,0 +1,5 @@
+int main() {
+    long s = 0;
+    int i;
+    for (i = 0; i < 1000000000; i = i + 1) s = s + i;
+}
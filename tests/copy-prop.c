@@ -0,0 +1,7 @@
+int main() {
+    int a[4], x = 7, y, z, i = 2;
+    y = x;
+    z = y + 3;
+    a[i] = z;
+    a[3] = a[i] + a[i];
+}
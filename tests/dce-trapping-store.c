@@ -0,0 +1,5 @@
+int main() {
+    int z = 0;
+    char v;
+    v = 7 / z;
+}
@@ -0,0 +1,5 @@
+int main() {
+    long b[2], q[1], r;
+    b[0] = 4;
+    r = q[0];
+}
@@ -0,0 +1,9 @@
+int main() {
+    int x = 3, y = 4, unused;
+    {
+    }
+    ;
+    y = x * 2;
+    x = x + 1;
+    int z = x;
+}
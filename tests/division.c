@@ -0,0 +1,4 @@
+int main() {
+    int x = 10 / 2, y = 7 % 4, z = 0;
+    x = x / z;
+}
@@ -0,0 +1,6 @@
+int main() {
+    int x = 3, y;
+    y = x + 1;
+    y = x * 5;
+    x = y;
+}
@@ -0,0 +1,4 @@
+int main() {
+    int i = 0;
+    for (i = 1;;) i = i + 1;
+}
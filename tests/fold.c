@@ -0,0 +1,5 @@
+int main() {
+    int x = 2 * 3 + 4;
+    char c = 60 + 5;
+    x = x + (7 - 5) * c;
+}
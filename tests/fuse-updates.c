@@ -0,0 +1,9 @@
+int main() {
+    int a[4], s = 1, i;
+    for (i = 0; i < 4; i = i + 1) {
+        a[i] = i;
+        a[i] = a[i] * 3;
+        s = s + a[i];
+    }
+    s = s << 2;
+}
@@ -0,0 +1,8 @@
+int main() {
+    int a[3], b[3], i;
+    for (i = 0; i < 3; i = i + 1) {
+        int t;
+    }
+    for (i = 0; i < 3; i = i + 1) a[i] = i * 2;
+    for (i = 0; i < 3; i = i + 1) b[i] = a[i] + 1;
+}
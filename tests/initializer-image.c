@@ -0,0 +1,8 @@
+int main() {
+    int x, i, s = 0;
+    for (x = 2; x < 4; x = x + 1) {
+        char c[5] = {65, x + 64, 67};
+        int a[6] = {x * 10, 5, x + 1};
+        s = s + a[0] + a[2] + a[5] + c[1] + c[4];
+    }
+}
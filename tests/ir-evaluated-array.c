@@ -0,0 +1,6 @@
+int main() {
+    int a[3], i, x;
+    a[0] = 1; a[1] = 2; a[2] = 3;
+    x = 0;
+    for (i = 0; i < 20; i = i + 1) x = x + a[i % 3] / (19 - i);
+}
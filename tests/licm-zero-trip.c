@@ -0,0 +1,5 @@
+int main() {
+    int s, arr[3], i, t = 0;
+    for (i = 0; i < 0; i = i + 1) t = t + s * 3 + arr[2];
+    t = 1;
+}
@@ -0,0 +1,4 @@
+int main() {
+    int a[4], i, x = 6, y = 7;
+    for (i = 0; i < 4; i = i + 1) a[i] = x * y + i;
+}
@@ -0,0 +1,7 @@
+int main() {
+    int i, j, s = 0;
+    for (i = 0; i < 3; i = i + 1) {
+        for (j = i; j < 3; j = j + 1) s = s + j;
+    }
+    for (; i > 0;) i = i - 2;
+}
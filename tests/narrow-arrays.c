@@ -0,0 +1,9 @@
+int main() {
+    int small[4], mid[4], big[4], i, s;
+    for (i = 0; i < 4; i = i + 1) {
+        small[i] = i * 3;
+        mid[i] = i * 1000;
+        big[i] = i * 100000;
+    }
+    s = small[3] + mid[2] - big[1] / 1000;
+}
@@ -0,0 +1,7 @@
+int main() {
+    char c = 300;
+    short s;
+    int i = 70000;
+    s = i;
+    c = c * 2;
+}
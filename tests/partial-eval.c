@@ -0,0 +1,5 @@
+int main() {
+    int a[4], s = 0, i;
+    for (i = 0; i < 4; i = i + 1) a[i] = i * i;
+    for (i = 0; i < 4; i = i + 1) s = s + a[i];
+}
@@ -0,0 +1,5 @@
+int main() {
+    int x = 3, y;
+    y = x * 4;
+    x = y + 0;
+}
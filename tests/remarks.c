@@ -0,0 +1,8 @@
+int main() {
+    int a[3], i, s = 0;
+    for (i = 0; i < 3; i = i + 1) a[i] = i;
+    for (i = 0; i < 6; i = i + 1) {
+        s = s + i;
+        i = i + 1;
+    }
+}
@@ -0,0 +1,6 @@
+int main() {
+    int x = 7, y;
+    y = x + 0;
+    y = 0 + y;
+    y = y - 0;
+}
@@ -0,0 +1,7 @@
+int main() {
+    int x = 5, y;
+    y = 3 + x;
+    y = 2 * y;
+    y = 10 < y;
+    y = 1 == y;
+}
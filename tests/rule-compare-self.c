@@ -0,0 +1,8 @@
+int main() {
+    char c = 'a';
+    int r;
+    r = c == c;
+    r = c < c;
+    r = c >= c;
+    r = c != c;
+}
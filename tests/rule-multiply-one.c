@@ -0,0 +1,6 @@
+int main() {
+    long x = -7, y;
+    y = x * 1;
+    y = 1 * y;
+    y = y / 1;
+}
@@ -0,0 +1,6 @@
+int main() {
+    int x = 4, y, z = 0;
+    y = x * 0;
+    y = 0 * y;
+    y = (x / z) * 0;
+}
@@ -0,0 +1,6 @@
+int main() {
+    int x = 100, y;
+    y = (x + 3) + 4;
+    y = (y - 2) + 5;
+    y = (y * 3) * 2;
+}
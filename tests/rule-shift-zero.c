@@ -0,0 +1,5 @@
+int main() {
+    int x = 12, y;
+    y = x << 0;
+    y = y >> 0;
+}
@@ -0,0 +1,5 @@
+int main() {
+    int x = 9, y, g;
+    y = x - x;
+    y = g - g;
+}
@@ -0,0 +1,107 @@
+#!/bin/sh
+# Runs every program in tests/ and compares its trace, the output of --int
+# including runtime errors, with the expected one next to it.
+#
+# Unoptimized, the trace must match exactly. Optimized, stores which were
+# removed aren't traced, so the trace may only lose lines of the expected one,
+# and it must end in the same runtime error, if any. A store removed by dead
+# store elimination is traced as "(eliminated)" in place of its value, and
+# compile-time warnings aren't part of the trace. The IR lowered from the
+# program must pass the verifier at every level.
+#
+# These only show that the passes don't break a program. A .check file next to
+# a program lists runs whose output shows that a pass did something, and a
+# program named rule-<name>.c also runs with only that simplifier rule, which
+# must rewrite something in it. A program without an expected trace, which
+# would take too long to run unoptimized, only runs with the flags of its
+# .check file and lowers its IR.
+#
+# Usage: tests/run.sh path/to/sbstcmp
+
+compiler=${1:-./sbstcmp}
+passes="fold simplify closed-form fuse unroll sra licm strength-reduce copy-prop dce dse bce narrow-arrays
+    storage partial-eval fuse-updates sccp"
+failures=0
+
+fail() {
+    echo "FAIL: $program $1"
+    failures=$((failures + 1))
+}
+
+# Compares the output of a run with the flags $1, given as $2, with the expected trace
+checkOptimized() {
+    flags=$1
+    actual=$(printf '%s\n' "$2" | grep -v -e '^\[Optimizer\]' -e ': warning: ')
+
+    if [ -n "$actual" ] && ! printf '%s\n' "$actual" | awk '
+        NR == FNR { lines[++count] = $0; next }
+        {
+            line = $0
+            isEliminated = sub(/ \(eliminated\)$/, "", line)
+            do { if (++i > count) exit 1 } while (isEliminated ? index(lines[i], line) != 1 : lines[i] != line)
+        }
+    ' "$expected" -; then
+        fail "$flags: the trace isn't part of the expected one"
+        printf '%s\n' "$actual"
+        return
+    fi
+
+    if [ "$(printf '%s\n' "$actual" | grep 'error')" != "$(grep 'error' "$expected")" ]; then
+        fail "$flags: the runtime errors differ"
+        printf '%s\n' "$actual" | grep 'error'
+    fi
+}
+
+for program in tests/*.c; do
+    expected="${program%.c}.expected"
+
+    if [ -f "$expected" ]; then
+        actual=$("$compiler" "$program" --int 2>&1)
+
+        if [ "$actual" != "$(cat "$expected")" ]; then
+            fail "-O0"
+            printf '%s\n' "$actual" | diff "$expected" -
+        fi
+
+        for flags in -O1 -O2 "-O2 --narrow-arrays" $(for pass in $passes; do echo "--passes=$pass"; done); do
+            # Word splitting of the flags is intended
+            checkOptimized "$flags" "$("$compiler" "$program" --int $flags 2>&1)"
+        done
+    fi
+
+    for flags in -O0 -O1 -O2; do
+        if ! output=$("$compiler" "$program" --emit-ir $flags 2>&1); then
+            fail "--emit-ir $flags: the IR isn't valid"
+            printf '%s\n' "$output" | grep 'ERROR'
+        fi
+    done
+
+    # Each line of a .check file holds flags, a tab, and an extended regular expression
+    # which a line printed by the compiler with those flags must match
+    check="${program%.c}.check"
+    if [ -f "$check" ]; then
+        while IFS='	' read -r flags pattern; do
+            # Word splitting of the flags is intended
+            if ! "$compiler" "$program" $flags 2>&1 | grep -q -E -e "$pattern"; then
+                fail "$flags: no line matches '$pattern'"
+            fi
+        done < "$check"
+    fi
+
+    case "$program" in
+        tests/rule-*)
+            rule=$(basename "$program" .c)
+            rule=${rule#rule-}
+            actual=$("$compiler" "$program" --int -v --passes=simplify --rules="$rule" 2>&1)
+
+            if ! printf '%s\n' "$actual" | grep -q "^\[Optimizer\]: $rule: [1-9]"; then
+                fail "--rules=$rule: the rule rewrote nothing"
+            fi
+
+            checkOptimized "--rules=$rule" "$actual"
+            ;;
+    esac
+done
+
+echo "$failures failure(s)"
+[ "$failures" -eq 0 ]
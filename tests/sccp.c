@@ -0,0 +1,5 @@
+int main() {
+    int x = 4, y, i;
+    y = x * 3;
+    for (i = 0; i < y - 12; i = i + 1) x = x + 1;
+}
@@ -0,0 +1,5 @@
+int main() {
+    int x = 3, z = 0, y;
+    y = 1;
+    y = x / (1 * (0 + z));
+}
@@ -0,0 +1,4 @@
+int main() {
+    int x;
+    int y = 0 + x;
+}
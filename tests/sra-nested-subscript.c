@@ -0,0 +1,7 @@
+int main() {
+    int a[3] = {10, 20, 30}, b[3] = {2, 0, 1}, i, s;
+    i = 1;
+    s = a[b[i]];
+    b[0] = 1;
+    s = s + a[b[0]];
+}
@@ -0,0 +1,8 @@
+int main() {
+    int a[3], b[2], s;
+    a[0] = 4;
+    a[1] = 5;
+    a[2] = a[0] + a[1];
+    b[0] = 3;
+    s = a[2] * b[0];
+}
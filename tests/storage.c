@@ -0,0 +1,15 @@
+int main() {
+    int s = 0, i;
+    {
+        int x = 3;
+        s = s + x;
+    }
+    {
+        int y = 4;
+        s = s + y;
+    }
+    for (i = 0; i < 2; i = i + 1) {
+        int z = i * 5;
+        s = s + z;
+    }
+}
@@ -0,0 +1,5 @@
+int main() {
+    int s, i, t = 0;
+    for (i = 0; i < 0; i = i + 1) t = t + i * s;
+    t = 2;
+}
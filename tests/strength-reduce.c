@@ -0,0 +1,6 @@
+int main() {
+    int a[4], i, x = 37, y, z;
+    for (i = 0; i < 4; i = i + 1) a[i] = i * 5;
+    y = x * 8;
+    z = x / 4;
+}
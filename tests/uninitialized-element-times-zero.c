@@ -0,0 +1,5 @@
+int main() {
+    int a[2], y;
+    a[0] = 1;
+    y = a[1] * 0;
+}
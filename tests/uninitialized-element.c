@@ -0,0 +1,5 @@
+int main() {
+    short a[2], x;
+    a[0] = 1;
+    x = a[0] + a[1];
+}
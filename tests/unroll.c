@@ -0,0 +1,6 @@
+int main() {
+    int a[10], s, i;
+    s = 5;
+    for (i = 0; i < 3; i = i + 1) s = s + i;
+    for (i = 0; i < 10; i = i + 1) a[i] = i * 3;
+}